@@ -0,0 +1,45 @@
+#include <chrono>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+template <typename Ingest>
+void Measure(const string& mark, const vector<NewDocument>& documents, const string& stop_words, Ingest ingest) {
+    SearchServer search_server(stop_words);
+    const auto start = chrono::steady_clock::now();
+    ingest(search_server, documents);
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << mark << ": "s << documents.size() / seconds << " docs/s ("s << seconds * 1000 << " ms, "s
+         << search_server.GetDocumentCount() << " documents)"s << endl;
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    const auto texts = GenerateQueries(generator, dictionary, 100'000, 50);
+    vector<NewDocument> documents;
+    documents.reserve(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        documents.push_back({static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+    cout << "hardware threads: "s << thread::hardware_concurrency() << endl;
+
+    Measure("AddDocument loop"s, documents, dictionary[0], [](SearchServer& search_server, const vector<NewDocument>& batch) {
+        for (const NewDocument& document : batch) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    });
+    Measure("AddDocuments(seq)"s, documents, dictionary[0], [](SearchServer& search_server, const vector<NewDocument>& batch) {
+        search_server.AddDocuments(execution::seq, batch);
+    });
+    Measure("AddDocuments(par)"s, documents, dictionary[0], [](SearchServer& search_server, const vector<NewDocument>& batch) {
+        search_server.AddDocuments(execution::par, batch);
+    });
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <sys/resource.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "../latency_histogram.h"
+
+// Наибольший объём резидентной памяти процесса за всё время работы, в килобайтах (Linux)
+inline uint64_t GetPeakRssKilobytes() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Процессорное время процесса (всех потоков) в секундах
+inline double GetCpuSeconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// Одна строка JSON с плоским объектом: результаты прогонов выводятся по строке на замер,
+// чтобы их можно было сравнивать между запусками обычными инструментами
+class JsonLine {
+public:
+    template <typename Value>
+    JsonLine& Add(std::string_view key, const Value& value) {
+        out_ << (is_empty_ ? "{"  : ", ");
+        is_empty_ = false;
+        WriteString(key);
+        out_ << ": ";
+        if constexpr (std::is_same_v<Value, bool>) {
+            out_ << (value ? "true" : "false");
+        } else if constexpr (std::is_arithmetic_v<Value>) {
+            out_ << value;
+        } else {
+            WriteString(value);
+        }
+        return *this;
+    }
+
+    // Процентили задержек в наносекундах
+    JsonLine& AddLatencies(const LatencyDistribution& latencies) {
+        return Add("p50_ns", latencies.GetPercentile(50).count())
+              .Add("p90_ns", latencies.GetPercentile(90).count())
+              .Add("p99_ns", latencies.GetPercentile(99).count())
+              .Add("p999_ns", latencies.GetPercentile(99.9).count())
+              .Add("max_ns", latencies.GetMax().count());
+    }
+
+    std::string ToString() const {
+        return is_empty_ ? "{}" : out_.str() + "}";
+    }
+
+private:
+    std::ostringstream out_;
+    bool is_empty_ = true;
+
+    void WriteString(std::string_view text) {
+        out_ << '"';
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                out_ << '\\';
+            }
+            out_ << c;
+        }
+        out_ << '"';
+    }
+};
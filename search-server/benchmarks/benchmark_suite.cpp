@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../process_queries.h"
+#include "../remove_duplicates.h"
+#include "../search_server.h"
+#include "benchmark_report.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+// Параметры задаются аргументами вида name=value, например sizes=10000,100000 zipf=1.1.
+// Каждый замер выводится строкой JSON; корпуса обрабатываются по возрастанию размера,
+// поэтому peak_rss_kb замера относится к самому большому индексу на этот момент
+struct SuiteOptions {
+    vector<int> sizes = {10'000, 100'000};
+    int vocabulary = 50'000;
+    double zipf = 1.0;
+    int min_document_words = 20;
+    int max_document_words = 80;
+    int query_words = 3;
+    double minus_share = 0.1;
+    int queries = 2'000;
+    int batch = 100;
+    double duplicate_share = 0.05;
+    double remove_share = 0.1;
+    unsigned seed = 1;
+};
+
+vector<int> ParseSizes(const string& text) {
+    vector<int> sizes;
+    istringstream input(text);
+    for (string size; getline(input, size, ',');) {
+        sizes.push_back(stoi(size));
+    }
+    return sizes;
+}
+
+SuiteOptions ParseOptions(int argc, char* argv[]) {
+    SuiteOptions options;
+    for (int index = 1; index < argc; ++index) {
+        const string argument = argv[index];
+        const size_t separator = argument.find('=');
+        if (separator == string::npos) {
+            throw invalid_argument("Expected name=value: "s + argument);
+        }
+        const string name = argument.substr(0, separator);
+        const string value = argument.substr(separator + 1);
+        if (name == "sizes"s) {
+            options.sizes = ParseSizes(value);
+        } else if (name == "vocabulary"s) {
+            options.vocabulary = stoi(value);
+        } else if (name == "zipf"s) {
+            options.zipf = stod(value);
+        } else if (name == "min_document_words"s) {
+            options.min_document_words = stoi(value);
+        } else if (name == "max_document_words"s) {
+            options.max_document_words = stoi(value);
+        } else if (name == "query_words"s) {
+            options.query_words = stoi(value);
+        } else if (name == "minus_share"s) {
+            options.minus_share = stod(value);
+        } else if (name == "queries"s) {
+            options.queries = stoi(value);
+        } else if (name == "batch"s) {
+            options.batch = stoi(value);
+        } else if (name == "duplicate_share"s) {
+            options.duplicate_share = stod(value);
+        } else if (name == "remove_share"s) {
+            options.remove_share = stod(value);
+        } else if (name == "seed"s) {
+            options.seed = stoul(value);
+        } else {
+            throw invalid_argument("Unknown option: "s + name);
+        }
+    }
+    const auto is_share = [](double share) {
+        return share >= 0 && share <= 1;
+    };
+    if (options.sizes.empty() || any_of(options.sizes.begin(), options.sizes.end(), [](int size) { return size <= 0; })) {
+        throw invalid_argument("Corpus sizes must be positive");
+    }
+    if (options.vocabulary <= 0 || options.queries <= 0 || options.batch <= 0 || options.query_words <= 0
+        || options.min_document_words <= 0 || options.min_document_words > options.max_document_words
+        || !is_share(options.minus_share) || !is_share(options.duplicate_share) || !is_share(options.remove_share)) {
+        throw invalid_argument("Invalid benchmark options");
+    }
+    return options;
+}
+
+class Measurement {
+public:
+    Measurement(string benchmark, string policy, size_t document_count)
+        : benchmark_(move(benchmark))
+        , policy_(move(policy))
+        , document_count_(document_count) {
+    }
+
+    // Замеряет один вызов, выполняющий item_count операций (для пачек запросов - больше одной)
+    template <typename Function>
+    void Run(Function function, size_t item_count = 1) {
+        const auto start = chrono::steady_clock::now();
+        function();
+        const chrono::nanoseconds elapsed = chrono::steady_clock::now() - start;
+        latencies_.Add(elapsed.count());
+        elapsed_ += elapsed;
+        items_ += item_count;
+    }
+
+    void Report() const {
+        const double seconds = chrono::duration<double>(elapsed_).count();
+        cout << JsonLine()
+                    .Add("benchmark", benchmark_)
+                    .Add("policy", policy_)
+                    .Add("documents", document_count_)
+                    .Add("calls", latencies_.GetCount())
+                    .Add("items", items_)
+                    .Add("seconds", seconds)
+                    .Add("items_per_second", seconds > 0 ? items_ / seconds : 0.0)
+                    .AddLatencies(latencies_)
+                    .Add("peak_rss_kb", GetPeakRssKilobytes())
+                    .ToString()
+             << endl;
+    }
+
+private:
+    string benchmark_;
+    string policy_;
+    size_t document_count_;
+    LatencyDistribution latencies_;
+    chrono::nanoseconds elapsed_{0};
+    uint64_t items_ = 0;
+};
+
+template <typename ExecutionPolicy>
+void MeasureFindTopDocuments(const string& policy_name, ExecutionPolicy policy, const SearchServer& search_server,
+                             const vector<string>& queries) {
+    Measurement measurement("FindTopDocuments"s, policy_name, search_server.GetDocumentCount());
+    for (const string& query : queries) {
+        measurement.Run([&] { search_server.FindTopDocuments(policy, query); });
+    }
+    measurement.Report();
+}
+
+template <typename ExecutionPolicy>
+void MeasureMatchDocument(const string& policy_name, ExecutionPolicy policy, const SearchServer& search_server,
+                          const vector<string>& queries, const vector<int>& document_ids) {
+    Measurement measurement("MatchDocument"s, policy_name, search_server.GetDocumentCount());
+    for (size_t index = 0; index < queries.size(); ++index) {
+        const int document_id = document_ids[index % document_ids.size()];
+        measurement.Run([&] { search_server.MatchDocument(policy, queries[index], document_id); });
+    }
+    measurement.Report();
+}
+
+template <typename ExecutionPolicy>
+void MeasureRemoveDocument(const string& policy_name, ExecutionPolicy policy, SearchServer& search_server,
+                           const vector<int>& document_ids) {
+    Measurement measurement("RemoveDocument"s, policy_name, search_server.GetDocumentCount());
+    for (const int document_id : document_ids) {
+        measurement.Run([&] { search_server.RemoveDocument(policy, document_id); });
+    }
+    measurement.Report();
+}
+
+template <typename Function>
+void MeasureBatches(const string& benchmark, const SearchServer& search_server, const vector<string>& queries,
+                    size_t batch_size, Function process) {
+    Measurement measurement(benchmark, "par"s, search_server.GetDocumentCount());
+    for (size_t begin = 0; begin < queries.size(); begin += batch_size) {
+        const vector<string> batch(queries.begin() + begin, queries.begin() + min(begin + batch_size, queries.size()));
+        measurement.Run([&] { process(search_server, batch); }, batch.size());
+    }
+    measurement.Report();
+}
+
+void RunCorpus(const SuiteOptions& options, const vector<string>& dictionary, const ZipfDistribution& zipf,
+               int document_count) {
+    mt19937 generator(options.seed + document_count);
+    vector<string> texts = GenerateZipfTexts(generator, dictionary, zipf, document_count,
+                                             options.min_document_words, options.max_document_words);
+    // Часть документов повторяет более ранние, чтобы RemoveDuplicates было что удалять
+    bernoulli_distribution is_duplicate(options.duplicate_share);
+    for (size_t index = 1; index < texts.size(); ++index) {
+        if (is_duplicate(generator)) {
+            texts[index] = texts[uniform_int_distribution<size_t>(0, index - 1)(generator)];
+        }
+    }
+    const vector<string> queries = GenerateZipfTexts(generator, dictionary, zipf, options.queries, 1,
+                                                     options.query_words, options.minus_share);
+
+    // Самое частое слово служит стоп-словом, как артикль в естественном языке
+    SearchServer search_server(dictionary[0]);
+    vector<int> document_ids;
+    {
+        Measurement measurement("AddDocument"s, "seq"s, texts.size());
+        for (int document_id = 0; document_id < document_count; ++document_id) {
+            measurement.Run([&] {
+                search_server.AddDocument(document_id, texts[document_id], DocumentStatus::ACTUAL, {document_id % 11 - 5});
+            });
+            document_ids.push_back(document_id);
+        }
+        measurement.Report();
+    }
+    shuffle(document_ids.begin(), document_ids.end(), generator);
+
+    MeasureFindTopDocuments("seq"s, execution::seq, search_server, queries);
+    MeasureFindTopDocuments("par"s, execution::par, search_server, queries);
+    MeasureMatchDocument("seq"s, execution::seq, search_server, queries, document_ids);
+    MeasureMatchDocument("par"s, execution::par, search_server, queries, document_ids);
+    MeasureBatches("ProcessQueries"s, search_server, queries, options.batch,
+                   [](const SearchServer& server, const vector<string>& batch) { ProcessQueries(server, batch); });
+    MeasureBatches("ProcessQueriesJoined"s, search_server, queries, options.batch,
+                   [](const SearchServer& server, const vector<string>& batch) { ProcessQueriesJoined(server, batch); });
+
+    {
+        // RemoveDuplicates печатает найденные id, а вывод занят результатами замеров
+        Measurement measurement("RemoveDuplicates"s, "par"s, search_server.GetDocumentCount());
+        ostringstream duplicates_log;
+        streambuf* const output = cout.rdbuf(duplicates_log.rdbuf());
+        measurement.Run([&] { RemoveDuplicates(search_server); }, search_server.GetDocumentCount());
+        cout.rdbuf(output);
+        measurement.Report();
+    }
+
+    // Удаляются случайные из оставшихся документов
+    vector<int> removed_ids(search_server.begin(), search_server.end());
+    shuffle(removed_ids.begin(), removed_ids.end(), generator);
+    removed_ids.resize(min<size_t>(removed_ids.size(), options.remove_share * document_count));
+    const auto middle = removed_ids.begin() + removed_ids.size() / 2;
+    MeasureRemoveDocument("seq"s, execution::seq, search_server, { removed_ids.begin(), middle });
+    MeasureRemoveDocument("par"s, execution::par, search_server, { middle, removed_ids.end() });
+}
+
+int main(int argc, char* argv[]) {
+    SuiteOptions options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    mt19937 generator(options.seed);
+    const auto dictionary = GenerateDictionary(generator, options.vocabulary, 10);
+    const ZipfDistribution zipf(dictionary.size(), options.zipf);
+
+    cout << JsonLine()
+                .Add("benchmark", "config")
+                .Add("vocabulary", options.vocabulary)
+                .Add("zipf", options.zipf)
+                .Add("min_document_words", options.min_document_words)
+                .Add("max_document_words", options.max_document_words)
+                .Add("query_words", options.query_words)
+                .Add("minus_share", options.minus_share)
+                .Add("queries", options.queries)
+                .Add("batch", options.batch)
+                .Add("duplicate_share", options.duplicate_share)
+                .Add("remove_share", options.remove_share)
+                .Add("seed", options.seed)
+                .Add("executor_threads", QueryExecutor::GetCurrent().GetThreadCount())
+                .ToString()
+         << endl;
+    vector<int> sizes = options.sizes;
+    sort(sizes.begin(), sizes.end());
+    for (const int size : sizes) {
+        RunCorpus(options, dictionary, zipf, size);
+    }
+}
@@ -0,0 +1,136 @@
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../concurrent_map.h"
+#include "../log_duration.h"
+
+using namespace std;
+
+// Прежняя реализация: std::map в каждом бакете, бакет выбирается как key % size
+template <typename Key, typename Value>
+class LegacyConcurrentMap {
+private:
+    struct MapMutex {
+        mutex mutex_;
+        map<Key, Value> map_;
+    };
+
+    vector<MapMutex> map_mutex_;
+
+public:
+    struct Access {
+        lock_guard<mutex> lock_guard_mutex;
+        Value& value_reference;
+
+        Access(const Key& key, MapMutex& map_mutex)
+            : lock_guard_mutex(map_mutex.mutex_)
+            , value_reference(map_mutex.map_[key]) {}
+    };
+
+    explicit LegacyConcurrentMap(size_t bucket_count)
+        : map_mutex_(bucket_count) {}
+
+    Access operator[](const Key& key) {
+        auto& bucket = map_mutex_[uint64_t(key) % map_mutex_.size()];
+        return {key, bucket};
+    }
+
+    map<Key, Value> BuildMap() {
+        map<Key, Value> result;
+        for (auto& [mutex_, map_] : map_mutex_) {
+            lock_guard lock_guard_mutex(mutex_);
+            result.insert(map_.begin(), map_.end());
+        }
+        return result;
+    }
+};
+
+template <typename Map>
+void RunWriters(const string& mark, int thread_count, int operation_count, int key_count) {
+    Map map(101);
+    {
+        LOG_DURATION(mark + " write x"s + to_string(thread_count));
+        vector<thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&map, t, operation_count, key_count]() {
+                mt19937 generator(t);
+                uniform_int_distribution<int> key(0, key_count - 1);
+                for (int i = 0; i < operation_count; ++i) {
+                    map[key(generator)].value_reference += 1;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    LOG_DURATION(mark + " build map"s);
+    cout << map.BuildMap().size() << endl;
+}
+
+// 95% чтений, 5% записей
+void RunReadMostly(int thread_count, int operation_count, int key_count) {
+    ConcurrentMap<int, int> map(101);
+    for (int key = 0; key < key_count; ++key) {
+        map[key].value_reference = key;
+    }
+    atomic<long long> checksum = 0;
+    LOG_DURATION("ConcurrentMap read-mostly x"s + to_string(thread_count));
+    vector<thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            mt19937 generator(t);
+            uniform_int_distribution<int> key(0, key_count - 1);
+            long long sum = 0;
+            for (int i = 0; i < operation_count; ++i) {
+                if (i % 20 == 0) {
+                    map[key(generator)].value_reference += 1;
+                } else if (const auto value = map.Find(key(generator))) {
+                    sum += *value;
+                }
+            }
+            checksum += sum;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    cout << checksum << endl;
+}
+
+void RunSnapshot(int key_count) {
+    ConcurrentMap<int, double> map(101);
+    for (int key = 0; key < key_count; ++key) {
+        map[key * 7].value_reference = key;
+    }
+    {
+        LOG_DURATION("ConcurrentMap snapshot"s);
+        cout << map.Snapshot().size() << endl;
+    }
+    LOG_DURATION("ConcurrentMap build map"s);
+    cout << map.BuildMap().size() << endl;
+}
+
+int main() {
+    const int operation_count = 1'000'000;
+    const int key_count = 100'000;
+    for (const int thread_count : {1, 2, 4, 8}) {
+        RunWriters<LegacyConcurrentMap<int, int>>("Legacy"s, thread_count, operation_count, key_count);
+        RunWriters<ConcurrentMap<int, int>>("ConcurrentMap"s, thread_count, operation_count, key_count);
+        RunReadMostly(thread_count, operation_count, key_count);
+    }
+    RunSnapshot(1'000'000);
+
+    // Нецелочисленный ключ - прежняя реализация такие ключи не поддерживала
+    ConcurrentMap<string, int> words(16);
+    for (const string& word : {"cat"s, "dog"s, "cat"s}) {
+        words[word].value_reference += 1;
+    }
+    cout << "cat: "s << *words.Find("cat"s) << endl;
+}
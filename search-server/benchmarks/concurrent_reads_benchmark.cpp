@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../concurrent_search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+const int kReaderCount = 3;
+const int kBatchSize = 100;
+// Читатели выдерживают паузу между запросами, как при умеренной нагрузке, а не загружают все ядра
+const auto kReaderPause = chrono::microseconds(500);
+
+struct LatencyReport {
+    vector<double> latencies_us;
+    double ingest_seconds = 0;
+};
+
+void Print(const string& mark, LatencyReport& report, size_t ingested) {
+    auto& latencies = report.latencies_us;
+    sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) {
+        return latencies[min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+    cout << mark << ": "s << latencies.size() << " queries, p50 "s << percentile(0.5) << " us, p99 "s << percentile(0.99)
+         << " us, max "s << latencies.back() << " us"s;
+    if (ingested > 0) {
+        cout << ", ingest "s << ingested / report.ingest_seconds << " docs/s"s;
+    }
+    cout << endl;
+}
+
+// Читатели выполняют запросы, пока писатель не закончит (или фиксированное время без писателя)
+template <typename Query, typename Ingest>
+LatencyReport Run(const vector<string>& queries, Query query, Ingest ingest) {
+    LatencyReport report;
+    atomic<bool> done{false};
+    vector<vector<double>> latencies(kReaderCount);
+    vector<thread> readers;
+    for (int reader = 0; reader < kReaderCount; ++reader) {
+        readers.emplace_back([&, reader] {
+            for (size_t i = reader; !done; i = (i + kReaderCount) % queries.size()) {
+                const auto start = chrono::steady_clock::now();
+                query(queries[i]);
+                latencies[reader].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+                this_thread::sleep_for(kReaderPause);
+            }
+        });
+    }
+    const auto start = chrono::steady_clock::now();
+    ingest();
+    report.ingest_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    done = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    for (const auto& reader_latencies : latencies) {
+        report.latencies_us.insert(report.latencies_us.end(), reader_latencies.begin(), reader_latencies.end());
+    }
+    return report;
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    const auto texts = GenerateQueries(generator, dictionary, 30'000, 50);
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 5);
+    const size_t initial_count = 20'000;
+
+    vector<vector<NewDocument>> batches;
+    for (size_t i = initial_count; i < texts.size(); i += kBatchSize) {
+        batches.emplace_back();
+        for (size_t j = i; j < min(texts.size(), i + kBatchSize); ++j) {
+            batches.back().push_back({static_cast<int>(j), texts[j], DocumentStatus::ACTUAL, {1}});
+        }
+    }
+    SearchServer initial(dictionary[0]);
+    for (size_t i = 0; i < initial_count; ++i) {
+        initial.AddDocument(i, texts[i], DocumentStatus::ACTUAL, {1});
+    }
+    const size_t ingested = texts.size() - initial_count;
+
+    {
+        ConcurrentSearchServer search_server(initial);
+        auto report = Run(queries, [&](const string& query) { search_server.FindTopDocuments(query); },
+                          [] { this_thread::sleep_for(chrono::seconds(2)); });
+        Print("reads only"s, report, 0);
+    }
+    {
+        // Для сравнения: общий shared_mutex, писатель останавливает всех читателей на время пачки
+        SearchServer search_server = initial;
+        shared_mutex mutex;
+        auto report = Run(queries, [&](const string& query) {
+            shared_lock lock(mutex);
+            search_server.FindTopDocuments(query);
+        }, [&] {
+            for (const auto& batch : batches) {
+                lock_guard lock(mutex);
+                search_server.AddDocuments(execution::par, batch);
+            }
+        });
+        Print("shared_mutex, reads during ingest"s, report, ingested);
+    }
+    {
+        ConcurrentSearchServer search_server(initial);
+        auto report = Run(queries, [&](const string& query) { search_server.FindTopDocuments(query); }, [&] {
+            for (const auto& batch : batches) {
+                search_server.AddDocuments(execution::par, batch);
+            }
+        });
+        Print("ConcurrentSearchServer, reads during ingest"s, report, ingested);
+    }
+}
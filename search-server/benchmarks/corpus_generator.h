@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+inline std::string GenerateWord(std::mt19937& generator, int max_length) {
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+inline std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    return words;
+}
+
+inline std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count, double minus_prob = 0) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+inline std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                                int query_count, int max_word_count, double minus_prob = 0) {
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count, minus_prob));
+    }
+    return queries;
+}
+
+// Распределение Ципфа на номерах 0..count-1: вероятность номера k пропорциональна 1 / (k + 1)^exponent,
+// как у частот слов естественного языка. Выбор - двоичный поиск по накопленным вероятностям
+class ZipfDistribution {
+public:
+    ZipfDistribution(size_t count, double exponent) {
+        cumulative_.reserve(count);
+        double sum = 0;
+        for (size_t rank = 1; rank <= count; ++rank) {
+            sum += 1 / std::pow(static_cast<double>(rank), exponent);
+            cumulative_.push_back(sum);
+        }
+    }
+
+    size_t operator()(std::mt19937& generator) const {
+        const double value = std::uniform_real_distribution<>(0, cumulative_.back())(generator);
+        const auto it = std::upper_bound(cumulative_.begin(), cumulative_.end(), value);
+        return std::min<size_t>(it - cumulative_.begin(), cumulative_.size() - 1);
+    }
+
+private:
+    std::vector<double> cumulative_;
+};
+
+inline std::string GenerateZipfText(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                    const ZipfDistribution& zipf, int word_count, double minus_prob = 0) {
+    std::string text;
+    for (int i = 0; i < word_count; ++i) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            text.push_back('-');
+        }
+        text += dictionary[zipf(generator)];
+    }
+    return text;
+}
+
+// Тексты длиной от min_word_count до max_word_count слов из словаря с частотами по Ципфу
+inline std::vector<std::string> GenerateZipfTexts(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                                  const ZipfDistribution& zipf, int text_count, int min_word_count,
+                                                  int max_word_count, double minus_prob = 0) {
+    std::vector<std::string> texts;
+    texts.reserve(text_count);
+    std::uniform_int_distribution<int> word_count(min_word_count, max_word_count);
+    for (int i = 0; i < text_count; ++i) {
+        texts.push_back(GenerateZipfText(generator, dictionary, zipf, word_count(generator), minus_prob));
+    }
+    return texts;
+}
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+template <typename Filter>
+void Test(const string& mark, const SearchServer& search_server, const vector<string>& queries, Filter filter) {
+    double total_relevance = 0;
+    {
+        LOG_DURATION(mark);
+        for (const string& query : queries) {
+            for (const auto& document : search_server.FindTopDocuments(query, filter)) {
+                total_relevance += document.relevance;
+            }
+        }
+    }
+    cout << total_relevance << endl;
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    vector<double> weights;
+    for (size_t rank = 1; rank <= dictionary.size(); ++rank) {
+        weights.push_back(1.0 / rank);
+    }
+    discrete_distribution<size_t> pick_word(weights.begin(), weights.end());
+    const auto generate_text = [&](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += dictionary[pick_word(generator)];
+            text.push_back(' ');
+        }
+        return text;
+    };
+
+    // Заблокирован каждый двадцатый документ, рейтинги от -10 до 10
+    SearchServer search_server(dictionary[0]);
+    uniform_int_distribution<int> rating(-10, 10);
+    for (int document_id = 0; document_id < 50'000; ++document_id) {
+        const DocumentStatus status = document_id % 20 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        search_server.AddDocument(document_id, generate_text(100), status, {rating(generator)});
+    }
+    vector<string> queries;
+    for (int i = 0; i < 2'000; ++i) {
+        queries.push_back(generate_text(3));
+    }
+
+    Test("BANNED, predicate"s, search_server, queries, [](int document_id, DocumentStatus status, int rating) {
+        return status == DocumentStatus::BANNED;
+    });
+    Test("BANNED, filter"s, search_server, queries, DocumentFilter{ DocumentStatus::BANNED });
+    Test("rating 8..10, predicate"s, search_server, queries, [](int document_id, DocumentStatus status, int rating) {
+        return rating >= 8 && rating <= 10;
+    });
+    Test("rating 8..10, filter"s, search_server, queries, DocumentFilter{ std::nullopt, 8, 10 });
+}
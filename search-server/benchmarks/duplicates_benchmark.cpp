@@ -0,0 +1,76 @@
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+// Прежний способ: словарь от наборов идентификаторов термов
+vector<int> FindDuplicatesByTermSets(const SearchServer& search_server, const vector<int>& document_ids) {
+    set<int> duplicates;
+    map<vector<TermId>, int> first_documents;
+    for (const int document_id : document_ids) {
+        if (!first_documents.emplace(search_server.GetDocumentTermIds(document_id), document_id).second) {
+            duplicates.insert(document_id);
+        }
+    }
+    return { duplicates.begin(), duplicates.end() };
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    uniform_int_distribution<size_t> pick_word(0, dictionary.size() - 1);
+    vector<string> texts;
+    // Каждый десятый документ повторяет один из предыдущих, каждый десятый - почти повторяет
+    for (int document_id = 0; document_id < 100'000; ++document_id) {
+        string text;
+        if (document_id > 0 && document_id % 10 == 0) {
+            text = texts[generator() % texts.size()];
+        } else if (document_id > 0 && document_id % 10 == 5) {
+            text = texts[generator() % texts.size()] + dictionary[pick_word(generator)];
+        } else {
+            for (int i = 0; i < 50; ++i) {
+                text += dictionary[pick_word(generator)] + " "s;
+            }
+        }
+        texts.push_back(move(text));
+    }
+    SearchServer search_server(dictionary[0]);
+    vector<int> document_ids;
+    for (int document_id = 0; document_id < static_cast<int>(texts.size()); ++document_id) {
+        search_server.AddDocument(document_id, texts[document_id], DocumentStatus::ACTUAL, {1});
+        document_ids.push_back(document_id);
+    }
+
+    {
+        LOG_DURATION("term id sets"s);
+        cout << FindDuplicatesByTermSets(search_server, document_ids).size() << endl;
+    }
+    {
+        LOG_DURATION("fingerprints, seq"s);
+        cout << search_server.FindDuplicates(execution::seq).size() << endl;
+    }
+    {
+        LOG_DURATION("fingerprints, par"s);
+        cout << search_server.FindDuplicates(execution::par).size() << endl;
+    }
+    {
+        LOG_DURATION("near duplicates, par"s);
+        cout << search_server.FindNearDuplicates(execution::par).size() << endl;
+    }
+    {
+        LOG_DURATION("FLAG policy, 1000 additions"s);
+        search_server.SetDuplicatePolicy(DuplicatePolicy::FLAG);
+        for (int document_id = 100'000; document_id < 101'000; ++document_id) {
+            search_server.AddDocument(document_id, texts[document_id % texts.size()], DocumentStatus::ACTUAL, {1});
+        }
+        cout << search_server.FindDuplicates().size() << endl;
+    }
+}
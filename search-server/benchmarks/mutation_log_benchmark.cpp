@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../mutation_log.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+const string kLogPath = "mutation_log_benchmark.wal"s;
+
+// Время добавления корпуса; при log_options добавления пишутся в журнал,
+// а wait_each_record ждёт сохранности каждой записи (без групповой фиксации)
+double MeasureIngest(const vector<string>& documents, const string& stop_words,
+                     const MutationLogOptions* log_options, bool wait_each_record, MutationLogStats* stats) {
+    remove(kLogPath.c_str());
+    SearchServer search_server(stop_words);
+    shared_ptr<MutationLog> log;
+    if (log_options != nullptr) {
+        log = make_shared<MutationLog>(kLogPath, *log_options);
+        search_server.SetMutationLog(log);
+    }
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        if (wait_each_record) {
+            log->Sync();
+        }
+    }
+    if (log) {
+        log->Sync();
+        *stats = log->GetStats();
+    }
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void Report(const string& mark, size_t document_count, double seconds, double baseline_seconds, const MutationLogStats* stats) {
+    cout << mark << ": "s << document_count / seconds << " docs/s, overhead "s
+         << (seconds / baseline_seconds - 1.0) * 100 << "%"s;
+    if (stats != nullptr) {
+        cout << ", "s << stats->bytes / 1024 << " KB in "s << stats->syncs << " syncs, "s
+             << chrono::duration<double, milli>(stats->sync_time).count() << " ms syncing in background"s;
+    }
+    cout << endl;
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 50);
+
+    const double baseline = MeasureIngest(documents, dictionary[0], nullptr, false, nullptr);
+    Report("no log"s, documents.size(), baseline, baseline, nullptr);
+
+    MutationLogStats stats;
+    MutationLogOptions no_fsync;
+    no_fsync.fsync = false;
+    Report("log without fsync"s, documents.size(), MeasureIngest(documents, dictionary[0], &no_fsync, false, &stats), baseline, &stats);
+
+    for (const size_t batch : {1, 64, 1024}) {
+        MutationLogOptions options;
+        options.sync_batch_records = batch;
+        options.sync_interval = chrono::milliseconds(10);
+        Report("group commit, batch "s + to_string(batch), documents.size(),
+               MeasureIngest(documents, dictionary[0], &options, false, &stats), baseline, &stats);
+    }
+
+    // Для сравнения: каждое добавление ждёт fsync своей записи
+    const vector<string> head(documents.begin(), documents.begin() + 1'000);
+    const double head_baseline = MeasureIngest(head, dictionary[0], nullptr, false, nullptr);
+    MutationLogOptions options;
+    Report("fsync per record (1000 docs)"s, head.size(), MeasureIngest(head, dictionary[0], &options, true, &stats), head_baseline, &stats);
+
+    MeasureIngest(documents, dictionary[0], &options, false, &stats);
+    SearchServer recovered(dictionary[0]);
+    const auto start = chrono::steady_clock::now();
+    const size_t records = MutationLog::Replay(kLogPath, recovered);
+    cout << "replay: "s << records << " records in "s
+         << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms"s << endl;
+    remove(kLogPath.c_str());
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../posting_codec.h"
+#include "../posting_list.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+void ReportMemory() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 50'000, 100);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    const IndexStats stats = search_server.GetIndexStats();
+    // Узел std::map<int, double>: три указателя, цвет, ключ и значение плюс заголовок аллокатора
+    const size_t map_node_bytes = 3 * sizeof(void*) + sizeof(int) * 2 + sizeof(double) + 2 * sizeof(void*);
+    cout << "terms: "s << stats.term_count << ", postings: "s << stats.posting_count << endl;
+    cout << "compressed: "s << stats.posting_bytes << " bytes, "s
+         << static_cast<double>(stats.posting_bytes) / stats.posting_count << " bytes/posting"s << endl;
+    cout << "term dictionary: "s << stats.dictionary_bytes << " bytes"s << endl;
+    cout << "std::map<int, double> estimate: "s << map_node_bytes << " bytes/posting"s << endl;
+}
+
+template <typename Decoder>
+void MeasureDecode(const string& mark, const vector<uint8_t>& data, size_t count, uint8_t width, Decoder decoder) {
+    const int repeat_count = 200;
+    vector<uint32_t> out(PostingList::kBlockSize);
+    uint64_t checksum = 0;
+    const auto start = chrono::steady_clock::now();
+    for (int repeat = 0; repeat < repeat_count; ++repeat) {
+        for (size_t block = 0; block * PostingList::kBlockSize < count; ++block) {
+            decoder(data.data() + block * PostingList::kBlockSize * width, PostingList::kBlockSize, width, 0, out.data());
+            checksum += out.back();
+        }
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    const double postings = static_cast<double>(count) * repeat_count;
+    cout << mark << " width "s << static_cast<int>(width) << ": "s << postings / seconds / 1e6 << " M postings/s, "s
+         << postings * width / seconds / 1e9 << " GB/s (checksum "s << checksum << ")"s << endl;
+}
+
+void ReportDecodeThroughput() {
+    const size_t count = 1'000'000 / PostingList::kBlockSize * PostingList::kBlockSize;
+    mt19937 generator;
+    for (const uint8_t width : {1, 2, 4}) {
+        const uint32_t max_value = width == 1 ? 0xFF : width == 2 ? 0xFFFF : 0xFFFFFF;
+        vector<uint32_t> values(count);
+        for (uint32_t& value : values) {
+            value = uniform_int_distribution<uint32_t>(0, max_value)(generator);
+        }
+        vector<uint8_t> data(count * width);
+        posting_codec::EncodeValues(values.data(), count, width, data.data());
+        MeasureDecode("scalar"s, data, count, width, posting_codec::DecodeDeltasScalar);
+        MeasureDecode(posting_codec::GetDecoderName(), data, count, width, posting_codec::DecodeDeltas);
+    }
+}
+
+int main() {
+    ReportMemory();
+    ReportDecodeThroughput();
+}
@@ -0,0 +1,76 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+// Счётчик выделений памяти во всей программе
+static atomic<size_t> allocation_count{0};
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    if (void* pointer = malloc(size > 0 ? size : 1)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+template <typename Queries>
+void Test(const string& mark, const SearchServer& search_server, const Queries& queries) {
+    size_t result_count = 0;
+    double total_relevance = 0;
+    const size_t allocations_before = allocation_count.load();
+    {
+        LOG_DURATION(mark);
+        for (const auto& query : queries) {
+            const auto documents = search_server.FindTopDocuments(query);
+            result_count += !documents.empty();
+            for (const auto& document : documents) {
+                total_relevance += document.relevance;
+            }
+        }
+    }
+    // Единственное ожидаемое выделение на запрос - вектор с результатом
+    const size_t allocations = allocation_count.load() - allocations_before;
+    cout << total_relevance << ", allocations per query "s << allocations * 1.0 / queries.size()
+         << ", non-empty results "s << result_count * 1.0 / queries.size() << endl;
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 50);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    const auto queries = GenerateQueries(generator, dictionary, 20'000, 4, 0.1);
+    vector<PreparedQuery> prepared_queries;
+    prepared_queries.reserve(queries.size());
+    for (const string& query : queries) {
+        prepared_queries.push_back(search_server.PrepareQuery(query));
+    }
+
+    // Первый проход прогревает буферы потока
+    Test("string queries (warm-up)"s, search_server, queries);
+    Test("string queries"s, search_server, queries);
+    Test("prepared queries"s, search_server, prepared_queries);
+}
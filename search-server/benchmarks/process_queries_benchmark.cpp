@@ -0,0 +1,58 @@
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../process_queries.h"
+#include "../query_executor.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+void Report(const string& mark, const BatchStats& stats) {
+    cout << mark << ": "s << stats.GetItemsPerSecond() << " queries/s, "s << stats.tasks << " tasks, "s
+         << stats.steals << " steals"s << endl;
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 10);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Много дешёвых запросов: накладные расходы планирования сравнимы с самим поиском
+    const auto queries = GenerateQueries(generator, dictionary, 20'000, 3);
+
+    {
+        LOG_DURATION("transform(par)"s);
+        vector<vector<Document>> results(queries.size());
+        transform(execution::par, queries.begin(), queries.end(), results.begin(),
+                  [&search_server](const string& query) { return search_server.FindTopDocuments(query); });
+    }
+
+    const size_t hardware_threads = max(1u, thread::hardware_concurrency());
+    for (const size_t thread_count : {size_t{1}, hardware_threads, 2 * hardware_threads}) {
+        QueryExecutor executor({thread_count, {}});
+        for (const size_t grain_size : {1, 16, 0}) {
+            BatchStats stats;
+            ProcessQueries(search_server, queries, executor, grain_size, &stats);
+            Report(to_string(thread_count) + " threads, grain "s + (grain_size == 0 ? "auto"s : to_string(grain_size)), stats);
+        }
+    }
+
+    // Вложенный параллелизм: запросы параллельно, и каждый поиск - тоже параллельно
+    QueryExecutor executor({hardware_threads, {}});
+    vector<vector<Document>> results(queries.size());
+    const BatchStats stats = executor.ParallelFor(queries.size(), 0, [&](size_t index) {
+        results[index] = search_server.FindTopDocuments(execution::par, queries[index]);
+    });
+    Report("nested par"s, stats);
+}
@@ -0,0 +1,50 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+void Test(const string& mark, const SearchServer& search_server, const vector<const string*>& traffic) {
+    LOG_DURATION(mark);
+    double total_relevance = 0;
+    for (const string* query : traffic) {
+        for (const auto& document : search_server.FindTopDocuments(*query)) {
+            total_relevance += document.relevance;
+        }
+    }
+    cout << total_relevance << endl;
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 50);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Перекошенный поток: номера запросов распределены по закону Ципфа
+    const auto distinct_queries = GenerateQueries(generator, dictionary, 10'000, 3, 0.1);
+    vector<double> weights;
+    for (size_t rank = 1; rank <= distinct_queries.size(); ++rank) {
+        weights.push_back(1.0 / rank);
+    }
+    discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    vector<const string*> traffic;
+    for (int i = 0; i < 20'000; ++i) {
+        traffic.push_back(&distinct_queries[pick(generator)]);
+    }
+
+    Test("no cache"s, search_server, traffic);
+    search_server.EnableQueryCache({2'048, 16});
+    Test("cache 2048"s, search_server, traffic);
+    const QueryCacheStats stats = search_server.GetQueryCacheStats();
+    cout << "hit rate "s << stats.GetHitRate() << ", evictions "s << stats.evictions << endl;
+}
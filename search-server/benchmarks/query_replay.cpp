@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../process_queries.h"
+#include "../query_executor.h"
+#include "../search_server.h"
+#include "benchmark_report.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+// Воспроизведение журнала запросов: documents - файл, каждая строка которого считается
+// документом (id - номер строки), queries - журнал, строка - запрос. Без файлов используется
+// сгенерированный корпус. Клиентские потоки выполняют запросы журнала по порядку:
+// mode=closed - каждый следующий запрос сразу после ответа на предыдущий,
+// mode=open - запрос i отправляется в момент i / rate от начала, и задержка отсчитывается
+// от этого момента, поэтому в неё входит ожидание в очереди, если сервер не успевает.
+// policy=seq|par - FindTopDocuments с этой политикой, policy=batch - ProcessQueries пачками.
+// Для каждого числа потоков из threads выводится строка JSON
+enum class ReplayMode {
+    CLOSED,
+    OPEN,
+};
+
+enum class ReplayPolicy {
+    SEQ,
+    PAR,
+    BATCH,
+};
+
+struct ReplayOptions {
+    string documents_path;
+    string queries_path;
+    string stop_words;
+    vector<size_t> threads = {1, 2, 4, 8};
+    ReplayMode mode = ReplayMode::CLOSED;
+    // Запросов в секунду для mode=open
+    double rate = 1'000;
+    ReplayPolicy policy = ReplayPolicy::SEQ;
+    size_t batch = 100;
+    // Сколько раз журнал проигрывается для каждого числа потоков
+    size_t repeat = 1;
+    // Потоки общего исполнителя, на котором работают par и batch (0 - по числу процессоров)
+    size_t executor_threads = 0;
+};
+
+vector<size_t> ParseCounts(const string& text) {
+    vector<size_t> counts;
+    istringstream input(text);
+    for (string count; getline(input, count, ',');) {
+        counts.push_back(stoul(count));
+    }
+    return counts;
+}
+
+ReplayOptions ParseOptions(int argc, char* argv[]) {
+    ReplayOptions options;
+    for (int index = 1; index < argc; ++index) {
+        const string argument = argv[index];
+        const size_t separator = argument.find('=');
+        if (separator == string::npos) {
+            throw invalid_argument("Expected name=value: "s + argument);
+        }
+        const string name = argument.substr(0, separator);
+        const string value = argument.substr(separator + 1);
+        if (name == "documents"s) {
+            options.documents_path = value;
+        } else if (name == "queries"s) {
+            options.queries_path = value;
+        } else if (name == "stop_words"s) {
+            options.stop_words = value;
+        } else if (name == "threads"s) {
+            options.threads = ParseCounts(value);
+        } else if (name == "mode"s && (value == "closed"s || value == "open"s)) {
+            options.mode = value == "open"s ? ReplayMode::OPEN : ReplayMode::CLOSED;
+        } else if (name == "rate"s) {
+            options.rate = stod(value);
+        } else if (name == "policy"s && (value == "seq"s || value == "par"s || value == "batch"s)) {
+            options.policy = value == "seq"s ? ReplayPolicy::SEQ : value == "par"s ? ReplayPolicy::PAR : ReplayPolicy::BATCH;
+        } else if (name == "batch"s) {
+            options.batch = stoul(value);
+        } else if (name == "repeat"s) {
+            options.repeat = stoul(value);
+        } else if (name == "executor_threads"s) {
+            options.executor_threads = stoul(value);
+        } else {
+            throw invalid_argument("Unknown option: "s + argument);
+        }
+    }
+    if (options.threads.empty() || find(options.threads.begin(), options.threads.end(), 0) != options.threads.end()
+        || options.rate <= 0 || options.batch == 0 || options.repeat == 0) {
+        throw invalid_argument("Invalid replay options");
+    }
+    return options;
+}
+
+vector<string> ReadLines(const string& path) {
+    ifstream input(path);
+    if (!input) {
+        throw invalid_argument("Cannot open "s + path);
+    }
+    vector<string> lines;
+    for (string line; getline(input, line);) {
+        // Табуляции и прочие управляющие символы сервер не принимает
+        replace_if(line.begin(), line.end(), [](char c) { return c >= '\0' && c < ' '; }, ' ');
+        lines.push_back(move(line));
+    }
+    return lines;
+}
+
+string GetPolicyName(ReplayPolicy policy) {
+    switch (policy) {
+        case ReplayPolicy::SEQ:
+            return "seq"s;
+        case ReplayPolicy::PAR:
+            return "par"s;
+        case ReplayPolicy::BATCH:
+            return "batch"s;
+    }
+    return "unknown"s;
+}
+
+// Пропускная способность считается только по запросам, получившим ответ
+struct ReplayResult {
+    size_t answered = 0;
+    size_t errors = 0;
+    double seconds = 0;
+    double cpu_seconds = 0;
+    LatencyDistribution latencies;
+
+    double GetQueriesPerSecond() const {
+        return seconds > 0 ? answered / seconds : 0.0;
+    }
+};
+
+// Запрос, который сервер отвергает (например, "--слово"), считается ошибкой, а не ответом
+bool ExecuteQuery(const SearchServer& search_server, const string& query, ReplayPolicy policy) {
+    try {
+        if (policy == ReplayPolicy::PAR) {
+            search_server.FindTopDocuments(execution::par, query);
+        } else {
+            search_server.FindTopDocuments(execution::seq, query);
+        }
+        return true;
+    } catch (const invalid_argument&) {
+        return false;
+    }
+}
+
+ReplayResult Replay(const SearchServer& search_server, const vector<string>& queries, const ReplayOptions& options,
+                    size_t thread_count) {
+    // Единица работы - запрос или пачка запросов; её номер задаёт и время отправки в режиме open
+    const size_t unit_size = options.policy == ReplayPolicy::BATCH ? options.batch : 1;
+    const size_t log_units = (queries.size() + unit_size - 1) / unit_size;
+    const size_t unit_count = log_units * options.repeat;
+    const chrono::nanoseconds interval(static_cast<int64_t>(1e9 * unit_size / options.rate));
+
+    atomic<size_t> next_unit{0};
+    atomic<size_t> errors{0};
+    LatencyHistogram latencies;
+    const double cpu_start = GetCpuSeconds();
+    const auto start = chrono::steady_clock::now();
+    const auto run_client = [&] {
+        vector<string> batch;
+        for (size_t unit = next_unit.fetch_add(1); unit < unit_count; unit = next_unit.fetch_add(1)) {
+            const size_t first = unit % log_units * unit_size;
+            const size_t last = min(first + unit_size, queries.size());
+            auto sent = chrono::steady_clock::now();
+            if (options.mode == ReplayMode::OPEN) {
+                sent = start + interval * unit;
+                this_thread::sleep_until(sent);
+            }
+            bool is_answered = true;
+            if (options.policy == ReplayPolicy::BATCH) {
+                batch.assign(queries.begin() + first, queries.begin() + last);
+                try {
+                    ProcessQueries(search_server, batch);
+                } catch (const invalid_argument&) {
+                    is_answered = false;
+                }
+            } else {
+                is_answered = ExecuteQuery(search_server, queries[first], options.policy);
+            }
+            if (!is_answered) {
+                // Отвергнутый запрос срывает всю пачку
+                errors.fetch_add(last - first, memory_order_relaxed);
+                continue;
+            }
+            // Каждый запрос пачки получает ответ вместе со всей пачкой
+            const auto latency = chrono::steady_clock::now() - sent;
+            for (size_t index = first; index < last; ++index) {
+                latencies.Record(latency);
+            }
+        }
+    };
+    vector<thread> clients;
+    for (size_t index = 1; index < thread_count; ++index) {
+        clients.emplace_back(run_client);
+    }
+    run_client();
+    for (thread& client : clients) {
+        client.join();
+    }
+
+    ReplayResult result;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.cpu_seconds = GetCpuSeconds() - cpu_start;
+    result.errors = errors.load();
+    result.answered = queries.size() * options.repeat - result.errors;
+    latencies.AddTo(result.latencies);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    ReplayOptions options;
+    vector<string> documents;
+    vector<string> queries;
+    try {
+        options = ParseOptions(argc, argv);
+        if (!options.documents_path.empty()) {
+            documents = ReadLines(options.documents_path);
+        }
+        if (!options.queries_path.empty()) {
+            queries = ReadLines(options.queries_path);
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    if (documents.empty() || queries.empty()) {
+        mt19937 generator;
+        const auto dictionary = GenerateDictionary(generator, 50'000, 10);
+        const ZipfDistribution zipf(dictionary.size(), 1.0);
+        if (documents.empty()) {
+            documents = GenerateZipfTexts(generator, dictionary, zipf, 50'000, 20, 80);
+            options.stop_words = dictionary[0];
+        }
+        if (queries.empty()) {
+            queries = GenerateZipfTexts(generator, dictionary, zipf, 10'000, 1, 3, 0.1);
+        }
+    }
+    if (options.executor_threads > 0) {
+        QueryExecutorOptions executor_options;
+        executor_options.thread_count = options.executor_threads;
+        QueryExecutor::ConfigureDefault(executor_options);
+    }
+
+    SearchServer search_server(options.stop_words);
+    size_t rejected_documents = 0;
+    for (size_t index = 0; index < documents.size(); ++index) {
+        try {
+            search_server.AddDocument(index, documents[index], DocumentStatus::ACTUAL, {});
+        } catch (const invalid_argument&) {
+            ++rejected_documents;
+        }
+    }
+    cout << JsonLine()
+                .Add("benchmark", "config")
+                .Add("documents", search_server.GetDocumentCount())
+                .Add("rejected_documents", rejected_documents)
+                .Add("queries", queries.size())
+                .Add("mode", options.mode == ReplayMode::OPEN ? "open" : "closed")
+                .Add("rate", options.mode == ReplayMode::OPEN ? options.rate : 0.0)
+                .Add("policy", GetPolicyName(options.policy))
+                .Add("batch", options.policy == ReplayPolicy::BATCH ? options.batch : size_t(1))
+                .Add("repeat", options.repeat)
+                .Add("executor_threads", QueryExecutor::GetDefault().GetThreadCount())
+                .Add("hardware_threads", thread::hardware_concurrency())
+                .Add("peak_rss_kb", GetPeakRssKilobytes())
+                .ToString()
+         << endl;
+
+    // Эффективность - пропускная способность на поток относительно первой точки
+    vector<size_t> thread_counts = options.threads;
+    sort(thread_counts.begin(), thread_counts.end());
+    double base_queries_per_thread = 0;
+    for (const size_t thread_count : thread_counts) {
+        const ReplayResult result = Replay(search_server, queries, options, thread_count);
+        const double queries_per_thread = result.GetQueriesPerSecond() / thread_count;
+        if (base_queries_per_thread == 0) {
+            base_queries_per_thread = queries_per_thread;
+        }
+        cout << JsonLine()
+                    .Add("benchmark", "replay")
+                    .Add("threads", thread_count)
+                    .Add("answered", result.answered)
+                    .Add("errors", result.errors)
+                    .Add("seconds", result.seconds)
+                    .Add("qps", result.GetQueriesPerSecond())
+                    .AddLatencies(result.latencies)
+                    .Add("efficiency", base_queries_per_thread > 0 ? queries_per_thread / base_queries_per_thread : 0.0)
+                    .Add("cpu_seconds", result.cpu_seconds)
+                    .Add("cpu_utilization", result.cpu_seconds / (result.seconds * thread_count))
+                    .Add("peak_rss_kb", GetPeakRssKilobytes())
+                    .ToString()
+             << endl;
+    }
+}
@@ -0,0 +1,52 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../query_trace.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+template <typename ExecutionPolicy>
+void RunQueries(const string& mark, const SearchServer& search_server, const vector<string>& queries,
+                ExecutionPolicy policy) {
+    LOG_DURATION(mark);
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(policy, query);
+    }
+}
+
+void PrintStats(const QueryTraceStats& stats) {
+    for (size_t stage = 0; stage < kQueryStageCount; ++stage) {
+        const QueryStageStats& stage_stats = stats.stages[stage];
+        cout << "  "s << GetQueryStageName(static_cast<QueryStage>(stage)) << ": "s << stage_stats.calls << " calls, "s
+             << stage_stats.elapsed.count() / max<uint64_t>(stats.queries, 1) << " ns per query"s << endl;
+    }
+    cout << "  "s << stats.queries << " queries, "s << stats.postings << " postings, "s << stats.candidates
+         << " candidates, "s << stats.matched_documents << " matched"s << endl;
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 10);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 5'000, 5, 0.1);
+
+    RunQueries("Tracing off, seq"s, search_server, queries, execution::seq);
+    RunQueries("Tracing off, par"s, search_server, queries, execution::par);
+
+    QueryTrace::SetEnabled(true);
+    QueryTrace::Reset();
+    RunQueries("Tracing on, seq"s, search_server, queries, execution::seq);
+    PrintStats(QueryTrace::GetStats());
+    QueryTrace::Reset();
+    RunQueries("Tracing on, par"s, search_server, queries, execution::par);
+    PrintStats(QueryTrace::GetStats());
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../request_queue.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+template <typename Function>
+void RunThreads(const string& mark, size_t thread_count, Function function) {
+    LOG_DURATION(mark);
+    vector<thread> threads;
+    for (size_t index = 0; index < thread_count; ++index) {
+        threads.emplace_back([&function, index, thread_count] { function(index, thread_count); });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 10);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 20'000, 3);
+
+    for (const size_t thread_count : {1, 4}) {
+        const string suffix = ", "s + to_string(thread_count) + " threads"s;
+        RunThreads("FindTopDocuments"s + suffix, thread_count, [&](size_t index, size_t count) {
+            for (size_t i = index; i < queries.size(); i += count) {
+                search_server.FindTopDocuments(queries[i]);
+            }
+        });
+        RequestQueue request_queue(search_server);
+        RunThreads("RequestQueue"s + suffix, thread_count, [&](size_t index, size_t count) {
+            for (size_t i = index; i < queries.size(); i += count) {
+                request_queue.AddFindRequest(queries[i]);
+            }
+        });
+        const RequestStats stats = request_queue.GetStats();
+        cout << stats.requests << " requests, "s << stats.no_result_requests << " without results, p50 "s
+             << stats.latencies.GetPercentile(50).count() << " ns, p99 "s << stats.latencies.GetPercentile(99).count()
+             << " ns, p99.9 "s << stats.latencies.GetPercentile(99.9).count() << " ns"s << endl;
+    }
+}
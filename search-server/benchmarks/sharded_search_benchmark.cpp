@@ -0,0 +1,51 @@
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "../sharded_search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+template <typename Server, typename ExecutionPolicy>
+void Test(const string& mark, const Server& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
+    LOG_DURATION(mark);
+    double total_relevance = 0;
+    for (const string_view query : queries) {
+        for (const auto& document : search_server.FindTopDocuments(policy, query)) {
+            total_relevance += document.relevance;
+        }
+    }
+    cout << total_relevance << endl;
+}
+
+int main() {
+    mt19937 generator;
+
+    // Небольшой словарь на большом корпусе: у каждого слова длинный список вхождений
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto texts = GenerateQueries(generator, dictionary, 100'000, 30);
+    vector<NewDocument> documents;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        documents.push_back({static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+
+    SearchServer search_server(dictionary[0]);
+    search_server.AddDocuments(execution::par, documents);
+    const size_t shard_count = max(2u, thread::hardware_concurrency());
+    ShardedSearchServer sharded_server(dictionary[0], shard_count);
+    sharded_server.AddDocuments(documents);
+
+    // Однословные запросы: у одного сервера параллелить внутри запроса почти нечего
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 1);
+
+    Test("single seq"s, search_server, queries, execution::seq);
+    Test("single par"s, search_server, queries, execution::par);
+    Test(to_string(shard_count) + " shards seq"s, sharded_server, queries, execution::seq);
+    Test(to_string(shard_count) + " shards par"s, sharded_server, queries, execution::par);
+}
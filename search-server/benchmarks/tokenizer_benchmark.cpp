@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../string_processing.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+// Прежняя схема: поиск пробелов через find/find_first_not_of и отдельный проход проверки символов
+bool SplitWithFind(string_view text, vector<string_view>& words) {
+    words.clear();
+    size_t start = text.find_first_not_of(' ');
+    while (start != text.npos) {
+        const size_t delimiter = text.find(' ', start);
+        words.push_back(text.substr(start, delimiter == text.npos ? text.npos : delimiter - start));
+        start = text.find_first_not_of(' ', delimiter);
+    }
+    return none_of(text.begin(), text.end(), [](char c) { return c >= '\0' && c < ' '; });
+}
+
+template <typename Split>
+void Measure(const string& mark, const vector<string>& lines, size_t total_bytes, Split split) {
+    const int kRepeats = 20;
+    vector<string_view> words;
+    size_t word_count = 0;
+    const auto start = chrono::steady_clock::now();
+    for (int repeat = 0; repeat < kRepeats; ++repeat) {
+        for (const string& line : lines) {
+            split(line, words);
+            word_count += words.size();
+        }
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << mark << ": "s << total_bytes * kRepeats / seconds / 1e9 << " GB/s ("s << word_count / kRepeats << " words)"s << endl;
+}
+
+// Аргумент - текстовый файл, каждая строка которого считается документом;
+// без него используется сгенерированный корпус
+int main(int argc, char* argv[]) {
+    vector<string> lines;
+    if (argc > 1) {
+        ifstream input(argv[1]);
+        for (string line; getline(input, line);) {
+            // Табуляции и прочие управляющие символы сервер не принимает
+            replace_if(line.begin(), line.end(), [](char c) { return c >= '\0' && c < ' '; }, ' ');
+            lines.push_back(move(line));
+        }
+    } else {
+        mt19937 generator;
+        const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+        lines = GenerateQueries(generator, dictionary, 50'000, 100);
+    }
+    size_t total_bytes = 0;
+    for (const string& line : lines) {
+        total_bytes += line.size();
+    }
+    cout << lines.size() << " lines, "s << total_bytes / (1 << 20) << " MB"s << endl;
+
+    Measure("find + none_of"s, lines, total_bytes, SplitWithFind);
+    Measure("SplitIntoWords"s, lines, total_bytes,
+            [](string_view text, vector<string_view>& words) { return SplitIntoWords(text, words); });
+}
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../query_trace.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+void Test(const string& mark, SearchServer search_server, QueryEngine query_engine, const vector<string>& queries) {
+    search_server.SetQueryEngine(query_engine);
+    double total_relevance = 0;
+    {
+        LOG_DURATION(mark);
+        for (const string& query : queries) {
+            for (const auto& document : search_server.FindTopDocuments(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+    }
+    // Вхождения считаются отдельным проходом, чтобы трассировка не влияла на замер
+    QueryTrace::SetEnabled(true);
+    QueryTrace::Reset();
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(query);
+    }
+    const QueryTraceStats stats = QueryTrace::GetStats();
+    QueryTrace::SetEnabled(false);
+    cout << total_relevance << ", postings per query "s << (stats.postings + stats.skipped_postings) / stats.queries
+         << ", visited "s << stats.postings / stats.queries
+         << ", skipped "s << stats.GetSkippedShare() * 100 << "%"s << endl;
+}
+
+int main() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    // Частоты слов распределены по закону Ципфа: несколько слов встречаются почти в каждом документе
+    vector<double> weights;
+    for (size_t rank = 1; rank <= dictionary.size(); ++rank) {
+        weights.push_back(1.0 / rank);
+    }
+    discrete_distribution<size_t> pick_word(weights.begin(), weights.end());
+    const auto generate_text = [&](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += dictionary[pick_word(generator)];
+            text.push_back(' ');
+        }
+        return text;
+    };
+
+    SearchServer search_server(dictionary[0]);
+    for (int document_id = 0; document_id < 50'000; ++document_id) {
+        search_server.AddDocument(document_id, generate_text(100), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Редкое слово вместе с частыми: почти все вхождения приходятся на частые слова
+    uniform_int_distribution<size_t> rare_word(1'000, dictionary.size() - 1);
+    vector<string> queries;
+    for (int i = 0; i < 2'000; ++i) {
+        queries.push_back(dictionary[rare_word(generator)] + " "s + generate_text(3));
+    }
+
+    Test("term-at-a-time"s, search_server, QueryEngine::TERM_AT_A_TIME, queries);
+    Test("WAND"s, search_server, QueryEngine::WAND, queries);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// FNV-1a по 64-битным словам; байты копятся между вызовами Update,
+// поэтому результат не зависит от того, какими кусками подаются данные
+class Checksum {
+public:
+    void Update(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0 && pending_size_ > 0) {
+            AddPendingByte(*bytes++);
+            --size;
+        }
+        for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, bytes, sizeof(word));
+            hash_ = (hash_ ^ word) * kPrime;
+        }
+        while (size-- > 0) {
+            AddPendingByte(*bytes++);
+        }
+    }
+
+    uint64_t Get() const {
+        uint64_t hash = hash_;
+        for (size_t i = 0; i < pending_size_; ++i) {
+            hash = (hash ^ pending_[i]) * kPrime;
+        }
+        return hash;
+    }
+
+    static uint64_t Compute(const void* data, size_t size) {
+        Checksum checksum;
+        checksum.Update(data, size);
+        return checksum.Get();
+    }
+
+    static const uint64_t kOffsetBasis = 14695981039346656037ull;
+    static const uint64_t kPrime = 1099511628211ull;
+
+private:
+    uint64_t hash_ = kOffsetBasis;
+    uint8_t pending_[sizeof(uint64_t)];
+    size_t pending_size_ = 0;
+
+    void AddPendingByte(uint8_t byte) {
+        pending_[pending_size_++] = byte;
+        if (pending_size_ == sizeof(uint64_t)) {
+            pending_size_ = 0;
+            Update(pending_, sizeof(uint64_t));
+        }
+    }
+};
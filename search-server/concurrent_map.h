@@ -1,52 +1,188 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <map>
-#include <vector>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
 
-#include "log_duration.h"
-
-using namespace std::string_literals;
-
-template <typename Key, typename Value>
+// Потокобезопасная хеш-таблица, разбитая на независимые шарды.
+// Каждый шард выровнен по кэш-линии и хранит элементы в открытой адресации
+// (линейное пробирование); чтение берёт разделяемую блокировку шарда,
+// запись - исключительную.
+template <typename Key, typename Value, typename Hasher = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
 class ConcurrentMap {
 private:
-    struct MapMutex {
-        std::mutex mutex_;
-        std::map<Key, Value> map_;
+    struct Slot {
+        std::optional<std::pair<Key, Value>> entry;
+        size_t hash = 0;
+        bool deleted = false;
     };
 
-    std::vector<MapMutex> map_mutex_;
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex_;
+        std::vector<Slot> slots_;
+        size_t size_ = 0;
+        size_t used_ = 0;  // заполненные ячейки вместе с удалёнными
+    };
 
 public:
     struct Access {
-        std::lock_guard<std::mutex> lock_guard_mutex;
+        std::unique_lock<std::shared_mutex> lock_guard_mutex;
         Value& value_reference;
-
-    Access(const Key& key, MapMutex& map_mutex)
-        : lock_guard_mutex(map_mutex.mutex_)
-        , value_reference(map_mutex.map_[key]) {}
     };
 
-    explicit ConcurrentMap(size_t bucket_count)
-        : map_mutex_(bucket_count) {}
+    explicit ConcurrentMap(size_t bucket_count, Hasher hasher = Hasher(), KeyEqual key_equal = KeyEqual())
+        : shards_(RoundUpToPowerOfTwo(bucket_count))
+        , shard_mask_(shards_.size() - 1)
+        , hasher_(std::move(hasher))
+        , key_equal_(std::move(key_equal)) {}
 
     Access operator[](const Key& key) {
-        auto& bucket = map_mutex_[uint64_t(key) % map_mutex_.size()];
-        return {key, bucket};
+        const size_t hash = Hash(key);
+        Shard& shard = shards_[hash & shard_mask_];
+        std::unique_lock lock(shard.mutex_);
+        Value& value = GetOrInsert(shard, key, hash);
+        return {std::move(lock), value};
+    }
+
+    std::optional<Value> Find(const Key& key) const {
+        const size_t hash = Hash(key);
+        const Shard& shard = shards_[hash & shard_mask_];
+        std::shared_lock lock(shard.mutex_);
+        const Slot* slot = FindSlot(shard, key, hash);
+        if (slot == nullptr) {
+            return std::nullopt;
+        }
+        return slot->entry->second;
+    }
+
+    bool Contains(const Key& key) const {
+        const size_t hash = Hash(key);
+        const Shard& shard = shards_[hash & shard_mask_];
+        std::shared_lock lock(shard.mutex_);
+        return FindSlot(shard, key, hash) != nullptr;
+    }
+
+    void Erase(const Key& key) {
+        const size_t hash = Hash(key);
+        Shard& shard = shards_[hash & shard_mask_];
+        std::unique_lock lock(shard.mutex_);
+        Slot* slot = const_cast<Slot*>(FindSlot(shard, key, hash));
+        if (slot != nullptr) {
+            slot->entry.reset();
+            slot->deleted = true;
+            --shard.size_;
+        }
+    }
+
+    size_t Size() const {
+        size_t size = 0;
+        for (const Shard& shard : shards_) {
+            std::shared_lock lock(shard.mutex_);
+            size += shard.size_;
+        }
+        return size;
+    }
+
+    // Копия содержимого без упорядочивания; каждый шард копируется под разделяемой блокировкой
+    std::vector<std::pair<Key, Value>> Snapshot() const {
+        std::vector<std::pair<Key, Value>> result;
+        result.reserve(Size());
+        for (const Shard& shard : shards_) {
+            std::shared_lock lock(shard.mutex_);
+            for (const Slot& slot : shard.slots_) {
+                if (slot.entry) {
+                    result.push_back(*slot.entry);
+                }
+            }
+        }
+        return result;
+    }
+
+    std::map<Key, Value> BuildMap() const {
+        auto snapshot = Snapshot();
+        return std::map<Key, Value>(std::make_move_iterator(snapshot.begin()), std::make_move_iterator(snapshot.end()));
     }
 
-    std::map<Key, Value> BuildMap() {
-        std::map<Key, Value> result;
-        for (auto& [mutex_, map_] : map_mutex_) {
-            std::lock_guard lock_guard_mutex(mutex_);
-            result.insert(map_.begin(), map_.end());
+private:
+    std::vector<Shard> shards_;
+    size_t shard_mask_;
+    Hasher hasher_;
+    KeyEqual key_equal_;
+
+    static size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
         }
         return result;
     }
 
-    void Erase(const Key& key){
-      auto& map_mutex = map_mutex_[static_cast<uint64_t>(key) % map_mutex_.size()];
-        std::lock_guard lock_guard_mutex(map_mutex.mutex_);
-        map_mutex.map_.erase(key);
+    // Перемешивание (хеширование Фибоначчи), чтобы тождественный std::hash
+    // для целых равномерно распределялся и по шардам, и по ячейкам внутри шарда
+    size_t Hash(const Key& key) const {
+        return static_cast<size_t>((static_cast<uint64_t>(hasher_(key)) * 0x9E3779B97F4A7C15ull) >> 16);
+    }
+
+    size_t SlotIndex(const Shard& shard, size_t hash) const {
+        return (hash / shards_.size()) & (shard.slots_.size() - 1);
+    }
+
+    const Slot* FindSlot(const Shard& shard, const Key& key, size_t hash) const {
+        if (shard.slots_.empty()) {
+            return nullptr;
+        }
+        for (size_t index = SlotIndex(shard, hash);; index = (index + 1) & (shard.slots_.size() - 1)) {
+            const Slot& slot = shard.slots_[index];
+            if (!slot.entry && !slot.deleted) {
+                return nullptr;
+            }
+            if (slot.entry && slot.hash == hash && key_equal_(slot.entry->first, key)) {
+                return &slot;
+            }
+        }
+    }
+
+    Value& GetOrInsert(Shard& shard, const Key& key, size_t hash) {
+        if (Slot* slot = const_cast<Slot*>(FindSlot(shard, key, hash))) {
+            return slot->entry->second;
+        }
+        if ((shard.used_ + 1) * 4 > shard.slots_.size() * 3) {
+            Rehash(shard);
+        }
+        size_t index = SlotIndex(shard, hash);
+        while (shard.slots_[index].entry) {
+            index = (index + 1) & (shard.slots_.size() - 1);
+        }
+        Slot& slot = shard.slots_[index];
+        if (!slot.deleted) {
+            ++shard.used_;
+        }
+        slot.entry.emplace(key, Value());
+        slot.hash = hash;
+        slot.deleted = false;
+        ++shard.size_;
+        return slot.entry->second;
+    }
+
+    void Rehash(Shard& shard) {
+        std::vector<Slot> old_slots = std::move(shard.slots_);
+        shard.slots_ = std::vector<Slot>(std::max<size_t>(8, RoundUpToPowerOfTwo((shard.size_ + 1) * 2)));
+        shard.used_ = shard.size_;
+        for (Slot& old_slot : old_slots) {
+            if (!old_slot.entry) {
+                continue;
+            }
+            size_t index = SlotIndex(shard, old_slot.hash);
+            while (shard.slots_[index].entry) {
+                index = (index + 1) & (shard.slots_.size() - 1);
+            }
+            shard.slots_[index] = std::move(old_slot);
+        }
     }
 };
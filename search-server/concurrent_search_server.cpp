@@ -0,0 +1,118 @@
+#include "concurrent_search_server.h"
+
+#include <functional>
+
+using namespace std;
+
+ConcurrentSearchServer::ConcurrentSearchServer(SearchServer search_server) {
+    search_server.SetMutationLog(nullptr);
+    servers_.reserve(2);
+    servers_.push_back(search_server);
+    servers_.push_back(move(search_server));
+}
+
+ConcurrentSearchServer::ReadGuard::ReadGuard(const SearchServer* search_server, atomic<int64_t>* reader_count)
+    : search_server_(search_server)
+    , reader_count_(reader_count) {
+}
+
+ConcurrentSearchServer::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+    : search_server_(other.search_server_)
+    , reader_count_(other.reader_count_) {
+    other.reader_count_ = nullptr;
+}
+
+ConcurrentSearchServer::ReadGuard::~ReadGuard() {
+    if (reader_count_ != nullptr) {
+        reader_count_->fetch_sub(1);
+    }
+}
+
+const SearchServer& ConcurrentSearchServer::ReadGuard::operator*() const {
+    return *search_server_;
+}
+
+const SearchServer* ConcurrentSearchServer::ReadGuard::operator->() const {
+    return search_server_;
+}
+
+ConcurrentSearchServer::ReadGuard ConcurrentSearchServer::Pin() const {
+    const size_t stripe = GetReaderStripe();
+    while (true) {
+        // Повторная проверка после регистрации: если писатель успел переключить версию,
+        // он мог не увидеть этого читателя, поэтому регистрация снимается и делается заново
+        const size_t published = published_.load();
+        atomic<int64_t>& reader_count = readers_[published][stripe].value;
+        reader_count.fetch_add(1);
+        if (published_.load() == published) {
+            return ReadGuard(&servers_[published], &reader_count);
+        }
+        reader_count.fetch_sub(1);
+    }
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const {
+    return Pin()->GetDocumentCount();
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    Apply([&](SearchServer& search_server) {
+        search_server.AddDocument(document_id, document, status, ratings);
+    }, [&] {
+        if (mutation_log_) {
+            mutation_log_->LogAdd(document_id, document, status, ratings);
+        }
+    });
+}
+
+void ConcurrentSearchServer::AddDocuments(const vector<NewDocument>& documents) {
+    AddDocuments(execution::par, documents);
+}
+
+void ConcurrentSearchServer::AddDocuments(const execution::parallel_policy&, const vector<NewDocument>& documents) {
+    Apply([&](SearchServer& search_server) {
+        search_server.AddDocuments(execution::par, documents);
+    }, [&] {
+        if (mutation_log_) {
+            for (const NewDocument& document : documents) {
+                mutation_log_->LogAdd(document.id, document.text, document.status, document.ratings);
+            }
+        }
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    RemoveDocuments({document_id});
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const vector<int>& document_ids) {
+    Apply([&](SearchServer& search_server) {
+        search_server.RemoveDocuments(execution::par, document_ids);
+    }, [&] {
+        if (mutation_log_) {
+            mutation_log_->LogRemove(document_ids);
+        }
+    });
+}
+
+void ConcurrentSearchServer::SetMutationLog(shared_ptr<MutationLog> mutation_log) {
+    lock_guard lock(writer_mutex_);
+    mutation_log_ = move(mutation_log);
+}
+
+uint64_t ConcurrentSearchServer::GetVersion() const {
+    return version_.load();
+}
+
+size_t ConcurrentSearchServer::GetReaderStripe() {
+    static thread_local const size_t stripe = hash<thread::id>()(this_thread::get_id()) % kReaderStripes;
+    return stripe;
+}
+
+void ConcurrentSearchServer::WaitForReaders(size_t server_index) const {
+    for (const ReaderCount& reader_count : readers_[server_index]) {
+        while (reader_count.value.load() != 0) {
+            this_thread::yield();
+        }
+    }
+}
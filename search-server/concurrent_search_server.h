@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mutation_log.h"
+#include "search_server.h"
+
+// Поисковый сервер для одновременных чтения и записи (схема left-right).
+// Хранятся две копии индекса: читатели без блокировок закрепляют опубликованную,
+// единственный писатель применяет изменение к второй копии, атомарно публикует её,
+// дожидается ухода читателей со старой копии и повторяет на ней то же изменение.
+// Задержка чтения не зависит от записи; цена - двойная память и двойная работа писателя.
+class ConcurrentSearchServer {
+public:
+    explicit ConcurrentSearchServer(SearchServer search_server);
+
+    // Закреплённая версия индекса: не меняется, пока жив объект
+    class ReadGuard {
+    public:
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard(ReadGuard&& other) noexcept;
+        ~ReadGuard();
+
+        const SearchServer& operator*() const;
+        const SearchServer* operator->() const;
+
+    private:
+        friend class ConcurrentSearchServer;
+        ReadGuard(const SearchServer* search_server, std::atomic<int64_t>* reader_count);
+
+        const SearchServer* search_server_;
+        std::atomic<int64_t>* reader_count_;
+    };
+
+    ReadGuard Pin() const;
+
+    // Выполняет function(const SearchServer&) на закреплённой версии
+    template <typename Function>
+    auto Read(Function function) const;
+
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(Args&&... args) const;
+    int GetDocumentCount() const;
+
+    // Изменения публикуются сразу по завершении вызова
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void AddDocuments(const std::vector<NewDocument>& documents);
+    void AddDocuments(const std::execution::parallel_policy&, const std::vector<NewDocument>& documents);
+    void RemoveDocument(int document_id);
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    // Произвольное изменение function(SearchServer&): применяется к обеим копиям и
+    // поэтому должно быть детерминированным. Если оно бросает исключение на первой
+    // копии (до изменения индекса), ничего не публикуется. Поток, удерживающий
+    // ReadGuard, не должен ничего изменять: писатель ждал бы его вечно
+    template <typename Function>
+    void Update(Function function);
+
+    // Журнал пишет обёртка: каждое изменение попадает в него один раз, до публикации
+    void SetMutationLog(std::shared_ptr<MutationLog> mutation_log);
+
+    // Номер опубликованной версии, растёт с каждым изменением
+    uint64_t GetVersion() const;
+
+private:
+    static const size_t kReaderStripes = 64;
+
+    // Счётчики читателей разнесены по кэш-линиям, чтобы читатели из разных потоков не мешали друг другу
+    struct alignas(64) ReaderCount {
+        std::atomic<int64_t> value{0};
+    };
+
+    std::vector<SearchServer> servers_;
+    mutable std::array<std::array<ReaderCount, kReaderStripes>, 2> readers_;
+    std::atomic<size_t> published_{0};
+    std::atomic<uint64_t> version_{0};
+    std::mutex writer_mutex_;
+    std::shared_ptr<MutationLog> mutation_log_;
+
+    static size_t GetReaderStripe();
+    void WaitForReaders(size_t server_index) const;
+
+    // before_publish вызывается после успешного изменения первой копии, до публикации
+    template <typename Function, typename BeforePublish>
+    void Apply(Function function, BeforePublish before_publish);
+};
+
+template <typename Function>
+auto ConcurrentSearchServer::Read(Function function) const {
+    const ReadGuard guard = Pin();
+    return function(*guard);
+}
+
+template <typename... Args>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(Args&&... args) const {
+    const ReadGuard guard = Pin();
+    return guard->FindTopDocuments(std::forward<Args>(args)...);
+}
+
+template <typename Function>
+void ConcurrentSearchServer::Update(Function function) {
+    Apply(function, [] {});
+}
+
+template <typename Function, typename BeforePublish>
+void ConcurrentSearchServer::Apply(Function function, BeforePublish before_publish) {
+    std::lock_guard lock(writer_mutex_);
+    const size_t published = published_.load();
+    const size_t next = 1 - published;
+    function(servers_[next]);
+    before_publish();
+    published_.store(next);
+    version_.fetch_add(1);
+    WaitForReaders(published);
+    function(servers_[published]);
+}
@@ -1,5 +1,8 @@
 #pragma once
+#include <cstddef>
 #include <iostream>
+#include <limits>
+#include <optional>
 
 struct Document {
     Document() = default;
@@ -18,4 +21,15 @@ enum class DocumentStatus {
     REMOVED,
 };
 
+const size_t kDocumentStatusCount = static_cast<size_t>(DocumentStatus::REMOVED) + 1;
+
+// Фильтр по статусу и диапазону рейтинга. В отличие от произвольного предиката,
+// сервер проверяет его по своим столбцам ещё до подсчёта релевантности документа
+struct DocumentFilter {
+    // Без значения подходит любой статус
+    std::optional<DocumentStatus> status;
+    int min_rating = std::numeric_limits<int>::min();
+    int max_rating = std::numeric_limits<int>::max();
+};
+
 std::ostream& operator << (std::ostream& out, const Document search);
@@ -0,0 +1,46 @@
+#include "document_fingerprint.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+const uint64_t kLowSeed = 0x9E3779B97F4A7C15ull;
+const uint64_t kHighSeed = 0xC2B2AE3D27D4EB4Full;
+const uint64_t kMinHashSeed = 0x165667B19E3779F9ull;
+
+}  // namespace
+
+uint64_t MixHash(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ull;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBull;
+    value ^= value >> 31;
+    return value;
+}
+
+Fingerprint ComputeWordFingerprint(string_view word) {
+    // Половины перемешивают одни и те же восьмибайтовые куски с разными зёрнами и операциями
+    uint64_t low = kLowSeed ^ word.size();
+    uint64_t high = kHighSeed + word.size();
+    size_t position = 0;
+    for (; position + sizeof(uint64_t) <= word.size(); position += sizeof(uint64_t)) {
+        uint64_t chunk;
+        memcpy(&chunk, word.data() + position, sizeof(chunk));
+        low = MixHash(low ^ chunk);
+        high = MixHash(high + chunk * kLowSeed);
+    }
+    uint64_t tail = 0;
+    if (position < word.size()) {
+        memcpy(&tail, word.data() + position, word.size() - position);
+    }
+    low = MixHash(low ^ tail ^ kHighSeed);
+    high = MixHash(high + tail * kLowSeed + kLowSeed);
+    return { low, high };
+}
+
+uint64_t ComputeMinHash(const Fingerprint& word_fingerprint, size_t index) {
+    return MixHash(word_fingerprint.low ^ (kMinHashSeed * (index + 1)));
+}
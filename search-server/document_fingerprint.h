@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 128-битный отпечаток набора слов документа. Отпечаток набора - сумма отпечатков его
+// различных слов по каждой половине: он не зависит от порядка слов и складывается по частям
+struct Fingerprint {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    Fingerprint& operator+=(const Fingerprint& other) {
+        low += other.low;
+        high += other.high;
+        return *this;
+    }
+};
+
+inline bool operator==(const Fingerprint& lhs, const Fingerprint& rhs) {
+    return lhs.low == rhs.low && lhs.high == rhs.high;
+}
+
+inline bool operator!=(const Fingerprint& lhs, const Fingerprint& rhs) {
+    return !(lhs == rhs);
+}
+
+inline bool operator<(const Fingerprint& lhs, const Fingerprint& rhs) {
+    return lhs.high != rhs.high ? lhs.high < rhs.high : lhs.low < rhs.low;
+}
+
+struct FingerprintHasher {
+    size_t operator()(const Fingerprint& fingerprint) const {
+        return fingerprint.low;
+    }
+};
+
+// Отпечаток одного слова: две независимые 64-битные половины
+Fingerprint ComputeWordFingerprint(std::string_view word);
+
+// Значение index-й хеш-функции MinHash для слова с данным отпечатком
+uint64_t ComputeMinHash(const Fingerprint& word_fingerprint, size_t index);
+
+// Перемешивание 64-битного значения (финализатор splitmix64)
+uint64_t MixHash(uint64_t value);
@@ -0,0 +1,726 @@
+#include "index_snapshot.h"
+#include "checksum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SNAPSHOT_USE_MMAP 1
+#define SNAPSHOT_USE_FSYNC 1
+#endif
+
+using namespace std;
+
+namespace {
+
+// Раскладка файла: заголовок, таблица секций, затем секции, каждая выровнена на 8 байт.
+// Секции идут в фиксированном порядке и являются плоскими массивами элементов
+// фиксированного размера, поэтому читаются прямо из отображения без разбора.
+enum SnapshotSection : uint32_t {
+    kStopWordOffsets,
+    kStopWordText,
+    kDocumentIds,
+    kRatings,
+    kStatuses,
+    kInverseWordCounts,
+    kForwardOffsets,
+    kForwardTermIds,
+    kForwardTermCounts,
+    kSortedDocumentIds,
+    kSortedOrdinals,
+    kTermOffsets,
+    kTermText,
+    kTermTable,
+    kPostingDirectory,
+    kPostingBlocks,
+    kPostingData,
+    kPostingTailOrdinals,
+    kPostingTailCounts,
+    kTermBounds,
+    kStatusBitmaps,
+    kSectionCount
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    uint64_t section_count;
+    uint64_t payload_checksum;
+    // Считается по заголовку с нулевым значением этого поля и по таблице секций
+    uint64_t header_checksum;
+};
+
+struct SectionEntry {
+    uint32_t id;
+    uint32_t element_size;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct PostingDirectoryEntry {
+    uint64_t first_block;
+    uint64_t data_offset;
+    uint64_t first_tail;
+    uint64_t size;
+    uint32_t block_count;
+    uint32_t tail_size;
+};
+
+static_assert(sizeof(FileHeader) == 48 && sizeof(SectionEntry) == 24 && sizeof(PostingDirectoryEntry) == 40,
+              "Snapshot structures must not contain implicit padding");
+static_assert(sizeof(DocumentStatus) == sizeof(uint32_t), "DocumentStatus is stored as a 32-bit value");
+
+const char kMagic[8] = {'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0'};
+const uint32_t kByteOrderMark = 0x01020304;
+
+const uint32_t kElementSizes[kSectionCount] = {
+    sizeof(uint64_t),              // kStopWordOffsets
+    sizeof(char),                  // kStopWordText
+    sizeof(int32_t),               // kDocumentIds
+    sizeof(int32_t),               // kRatings
+    sizeof(DocumentStatus),        // kStatuses
+    sizeof(double),                // kInverseWordCounts
+    sizeof(uint64_t),              // kForwardOffsets
+    sizeof(TermId),                // kForwardTermIds
+    sizeof(uint32_t),              // kForwardTermCounts
+    sizeof(int32_t),               // kSortedDocumentIds
+    sizeof(DocumentOrdinal),       // kSortedOrdinals
+    sizeof(uint64_t),              // kTermOffsets
+    sizeof(char),                  // kTermText
+    sizeof(uint32_t),              // kTermTable
+    sizeof(PostingDirectoryEntry), // kPostingDirectory
+    sizeof(PostingBlock),          // kPostingBlocks
+    sizeof(uint8_t),               // kPostingData
+    sizeof(DocumentOrdinal),       // kPostingTailOrdinals
+    sizeof(uint32_t),              // kPostingTailCounts
+    sizeof(TermBounds),            // kTermBounds
+    sizeof(uint64_t),              // kStatusBitmaps
+};
+
+uint64_t HashTerm(string_view term) {
+    uint64_t hash = Checksum::kOffsetBasis;
+    for (const char c : term) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * Checksum::kPrime;
+    }
+    return hash;
+}
+
+size_t AlignSize(size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+// Секция при записи собирается из кусков чужой памяти без копирования
+struct SectionParts {
+    vector<pair<const void*, size_t>> parts;
+    size_t size = 0;
+
+    void Add(const void* data, size_t size_in_bytes) {
+        if (size_in_bytes > 0) {
+            parts.emplace_back(data, size_in_bytes);
+            size += size_in_bytes;
+        }
+    }
+};
+
+template <typename T>
+void AddVector(SectionParts& section, const vector<T>& values) {
+    section.Add(values.data(), values.size() * sizeof(T));
+}
+
+void CheckStream(const ofstream& out, const string& path) {
+    if (!out) {
+        throw runtime_error("Failed to write index snapshot " + path);
+    }
+}
+
+// Сбрасывает на диск содержимое файла или каталога (для каталога - записи о переименованиях в нём)
+bool SyncPath(const string& path) {
+#ifdef SNAPSHOT_USE_FSYNC
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    const bool synced = fsync(descriptor) == 0;
+    close(descriptor);
+    return synced;
+#else
+    (void)path;
+    return true;
+#endif
+}
+
+string GetParentDirectory(const string& path) {
+    const size_t slash = path.find_last_of('/');
+    if (slash == string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+} // namespace
+
+void WriteIndexSnapshot(const string& path, const SnapshotContent& content) {
+    vector<SectionParts> sections(kSectionCount);
+    const size_t ordinal_count = content.ordinal_count;
+
+    vector<uint64_t> stop_word_offsets{0};
+    string stop_word_text;
+    for (string_view word : content.stop_words) {
+        stop_word_text += word;
+        stop_word_offsets.push_back(stop_word_text.size());
+    }
+    AddVector(sections[kStopWordOffsets], stop_word_offsets);
+    sections[kStopWordText].Add(stop_word_text.data(), stop_word_text.size());
+
+    sections[kDocumentIds].Add(content.document_ids, ordinal_count * sizeof(int));
+    sections[kRatings].Add(content.ratings, ordinal_count * sizeof(int));
+    sections[kStatuses].Add(content.statuses, ordinal_count * sizeof(DocumentStatus));
+    sections[kInverseWordCounts].Add(content.inverse_word_counts, ordinal_count * sizeof(double));
+    const size_t forward_size = content.forward_offsets[ordinal_count];
+    sections[kForwardOffsets].Add(content.forward_offsets, (ordinal_count + 1) * sizeof(uint64_t));
+    sections[kForwardTermIds].Add(content.forward_term_ids, forward_size * sizeof(TermId));
+    sections[kForwardTermCounts].Add(content.forward_term_counts, forward_size * sizeof(uint32_t));
+    for (const uint64_t* words : content.status_bitmaps) {
+        sections[kStatusBitmaps].Add(words, OrdinalBitmap::GetWordCount(ordinal_count) * sizeof(uint64_t));
+    }
+
+    vector<pair<int, DocumentOrdinal>> live_documents;
+    for (DocumentOrdinal ordinal = 0; ordinal < ordinal_count; ++ordinal) {
+        if (content.document_ids[ordinal] >= 0) {
+            live_documents.emplace_back(content.document_ids[ordinal], ordinal);
+        }
+    }
+    sort(live_documents.begin(), live_documents.end());
+    vector<int> sorted_ids;
+    vector<DocumentOrdinal> sorted_ordinals;
+    sorted_ids.reserve(live_documents.size());
+    sorted_ordinals.reserve(live_documents.size());
+    for (const auto& [document_id, ordinal] : live_documents) {
+        sorted_ids.push_back(document_id);
+        sorted_ordinals.push_back(ordinal);
+    }
+    AddVector(sections[kSortedDocumentIds], sorted_ids);
+    AddVector(sections[kSortedOrdinals], sorted_ordinals);
+
+    // Словарь: тексты термов подряд и хеш-таблица с открытой адресацией (id + 1, 0 - пусто)
+    vector<uint64_t> term_offsets{0};
+    size_t term_text_size = 0;
+    size_t term_count = 0;
+    for (string_view term : content.terms) {
+        term_text_size += term.size();
+        term_offsets.push_back(term_text_size);
+        term_count += term.empty() ? 0 : 1;
+    }
+    for (string_view term : content.terms) {
+        sections[kTermText].Add(term.data(), term.size());
+    }
+    size_t table_size = 2;
+    while (table_size < 2 * term_count) {
+        table_size <<= 1;
+    }
+    vector<uint32_t> term_table(table_size, 0);
+    for (TermId term_id = 0; term_id < content.terms.size(); ++term_id) {
+        if (content.terms[term_id].empty()) {
+            continue;
+        }
+        size_t index = HashTerm(content.terms[term_id]) & (table_size - 1);
+        while (term_table[index] != 0) {
+            index = (index + 1) & (table_size - 1);
+        }
+        term_table[index] = term_id + 1;
+    }
+    AddVector(sections[kTermOffsets], term_offsets);
+    AddVector(sections[kTermTable], term_table);
+
+    // Блоки всех списков пишутся подряд; смещения внутри блоков остаются относительными
+    // к началу данных своего терма, его положение хранится в каталоге
+    vector<PostingDirectoryEntry> directory;
+    directory.reserve(content.postings.size());
+    size_t block_count = 0;
+    size_t data_size = 0;
+    size_t tail_size = 0;
+    for (const PostingListView& postings : content.postings) {
+        directory.push_back({block_count, data_size, tail_size, postings.Size(),
+                             static_cast<uint32_t>(postings.GetBlockCount()), static_cast<uint32_t>(postings.GetTailSize())});
+        sections[kPostingBlocks].Add(postings.GetBlocks(), postings.GetBlockCount() * sizeof(PostingBlock));
+        sections[kPostingData].Add(postings.GetData(), postings.GetDataSize());
+        sections[kPostingTailOrdinals].Add(postings.GetTailOrdinals(), postings.GetTailSize() * sizeof(DocumentOrdinal));
+        sections[kPostingTailCounts].Add(postings.GetTailCounts(), postings.GetTailSize() * sizeof(uint32_t));
+        block_count += postings.GetBlockCount();
+        data_size += postings.GetDataSize();
+        tail_size += postings.GetTailSize();
+    }
+    AddVector(sections[kPostingDirectory], directory);
+    sections[kTermBounds].Add(content.term_bounds, content.terms.size() * sizeof(TermBounds));
+
+    FileHeader header{};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kSnapshotVersion;
+    header.byte_order = kByteOrderMark;
+    header.section_count = kSectionCount;
+    vector<SectionEntry> table(kSectionCount);
+    size_t offset = sizeof(FileHeader) + kSectionCount * sizeof(SectionEntry);
+    for (uint32_t id = 0; id < kSectionCount; ++id) {
+        table[id] = {id, kElementSizes[id], offset, sections[id].size};
+        offset += AlignSize(sections[id].size);
+    }
+    header.file_size = offset;
+
+    const string temporary_path = path + ".tmp";
+    {
+        ofstream out(temporary_path, ios::binary | ios::trunc);
+        CheckStream(out, temporary_path);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(SectionEntry));
+
+        Checksum payload_checksum;
+        const char padding[8] = {};
+        for (const SectionParts& section : sections) {
+            for (const auto& [data, size] : section.parts) {
+                out.write(static_cast<const char*>(data), size);
+                payload_checksum.Update(data, size);
+            }
+            const size_t padding_size = AlignSize(section.size) - section.size;
+            out.write(padding, padding_size);
+            payload_checksum.Update(padding, padding_size);
+        }
+        CheckStream(out, temporary_path);
+
+        header.payload_checksum = payload_checksum.Get();
+        Checksum header_checksum;
+        header_checksum.Update(&header, sizeof(header));
+        header_checksum.Update(table.data(), table.size() * sizeof(SectionEntry));
+        header.header_checksum = header_checksum.Get();
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        CheckStream(out, temporary_path);
+    }
+    // Данные должны оказаться на диске раньше, чем переименование сделает файл снимком,
+    // а само переименование - раньше, чем вызывающий очистит журнал изменений
+    if (!SyncPath(temporary_path)) {
+        remove(temporary_path.c_str());
+        throw runtime_error("Failed to sync index snapshot " + temporary_path);
+    }
+    if (rename(temporary_path.c_str(), path.c_str()) != 0) {
+        remove(temporary_path.c_str());
+        throw runtime_error("Failed to replace index snapshot " + path);
+    }
+    if (!SyncPath(GetParentDirectory(path))) {
+        throw runtime_error("Failed to sync directory of index snapshot " + path);
+    }
+}
+
+shared_ptr<const IndexSnapshot> IndexSnapshot::Open(const string& path, bool verify_checksum, bool verify_structure) {
+    shared_ptr<IndexSnapshot> snapshot(new IndexSnapshot());
+    snapshot->Map(path);
+    snapshot->Validate(verify_checksum, verify_structure);
+    return snapshot;
+}
+
+IndexSnapshot::~IndexSnapshot() {
+#ifdef SNAPSHOT_USE_MMAP
+    if (mapping_ != nullptr) {
+        munmap(const_cast<uint8_t*>(mapping_), mapping_size_);
+    }
+#endif
+}
+
+void IndexSnapshot::Map(const string& path) {
+#ifdef SNAPSHOT_USE_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Failed to open index snapshot " + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        close(fd);
+        throw runtime_error("Index snapshot is truncated: " + path);
+    }
+    void* mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw runtime_error("Failed to map index snapshot " + path);
+    }
+    mapping_ = static_cast<const uint8_t*>(mapping);
+    mapping_size_ = file_stat.st_size;
+#else
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in) {
+        throw runtime_error("Failed to open index snapshot " + path);
+    }
+    mapping_size_ = in.tellg();
+    buffer_.resize((mapping_size_ + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(buffer_.data()), mapping_size_);
+    if (!in) {
+        throw runtime_error("Failed to read index snapshot " + path);
+    }
+    mapping_ = reinterpret_cast<const uint8_t*>(buffer_.data());
+#endif
+}
+
+void IndexSnapshot::Validate(bool verify_checksum, bool verify_structure) {
+    if (mapping_size_ < sizeof(FileHeader)) {
+        throw runtime_error("Index snapshot is truncated");
+    }
+    FileHeader header;
+    memcpy(&header, mapping_, sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw runtime_error("File is not an index snapshot");
+    }
+    if (header.byte_order != kByteOrderMark) {
+        throw runtime_error("Index snapshot was written with a different byte order");
+    }
+    if (header.version != kSnapshotVersion) {
+        throw runtime_error("Unsupported index snapshot version " + to_string(header.version));
+    }
+    const size_t payload_offset = sizeof(FileHeader) + kSectionCount * sizeof(SectionEntry);
+    if (header.file_size != mapping_size_ || header.section_count != kSectionCount || mapping_size_ < payload_offset) {
+        throw runtime_error("Index snapshot is truncated or has an unexpected layout");
+    }
+
+    const uint64_t expected_header_checksum = header.header_checksum;
+    header.header_checksum = 0;
+    Checksum header_checksum;
+    header_checksum.Update(&header, sizeof(header));
+    header_checksum.Update(mapping_ + sizeof(FileHeader), kSectionCount * sizeof(SectionEntry));
+    if (header_checksum.Get() != expected_header_checksum) {
+        throw runtime_error("Index snapshot header checksum mismatch");
+    }
+
+    sections_.resize(kSectionCount);
+    for (uint32_t id = 0; id < kSectionCount; ++id) {
+        SectionEntry entry;
+        memcpy(&entry, mapping_ + sizeof(FileHeader) + id * sizeof(SectionEntry), sizeof(entry));
+        if (entry.id != id || entry.element_size != kElementSizes[id] || entry.offset % 8 != 0
+            || entry.offset < payload_offset || entry.offset > mapping_size_ || entry.size > mapping_size_ - entry.offset
+            || entry.size % entry.element_size != 0) {
+            throw runtime_error("Index snapshot has a malformed section table");
+        }
+        sections_[id] = {mapping_ + entry.offset, entry.size};
+    }
+
+    if (verify_checksum) {
+        Checksum payload_checksum;
+        payload_checksum.Update(mapping_ + payload_offset, mapping_size_ - payload_offset);
+        if (payload_checksum.Get() != header.payload_checksum) {
+            throw runtime_error("Index snapshot data checksum mismatch");
+        }
+    }
+
+    const size_t ordinal_count = GetOrdinalCount();
+    const size_t table_size = GetSectionLength(kTermTable, sizeof(uint32_t));
+    const size_t term_offset_count = GetSectionLength(kTermOffsets, sizeof(uint64_t));
+    if (GetSectionLength(kRatings, sizeof(int)) != ordinal_count
+        || GetSectionLength(kStatuses, sizeof(DocumentStatus)) != ordinal_count
+        || GetSectionLength(kInverseWordCounts, sizeof(double)) != ordinal_count
+        || GetSectionLength(kForwardOffsets, sizeof(uint64_t)) != ordinal_count + 1
+        || GetSectionLength(kForwardTermIds, sizeof(TermId)) != GetForwardOffsets()[ordinal_count]
+        || GetSectionLength(kForwardTermCounts, sizeof(uint32_t)) != GetForwardOffsets()[ordinal_count]
+        || GetSectionLength(kStatusBitmaps, sizeof(uint64_t)) != kDocumentStatusCount * OrdinalBitmap::GetWordCount(ordinal_count)
+        || GetSectionLength(kSortedOrdinals, sizeof(DocumentOrdinal)) != GetDocumentCount()
+        || GetSectionLength(kStopWordOffsets, sizeof(uint64_t)) == 0
+        || term_offset_count == 0
+        || GetSectionLength(kPostingDirectory, sizeof(PostingDirectoryEntry)) != term_offset_count - 1
+        || GetSectionLength(kTermBounds, sizeof(TermBounds)) != term_offset_count - 1
+        || GetSection<uint64_t>(kTermOffsets)[term_offset_count - 1] != sections_[kTermText].size
+        || table_size == 0 || (table_size & (table_size - 1)) != 0) {
+        throw runtime_error("Index snapshot sections are inconsistent");
+    }
+    // Стоп-слова читаются уже при открытии, а их немного
+    ValidateStopWords();
+    if (!verify_structure) {
+        return;
+    }
+
+    // Смещения, номера и идентификаторы внутри секций используются как индексы массивов
+    // без проверок, поэтому повреждённый файл должен отвергаться здесь, а не при запросе
+    ValidateDocuments();
+    ValidateTerms();
+    ValidatePostings();
+}
+
+void IndexSnapshot::ValidateStopWords() const {
+    const uint64_t* offsets = GetSection<uint64_t>(kStopWordOffsets);
+    const size_t offset_count = GetSectionLength(kStopWordOffsets, sizeof(uint64_t));
+    CheckOffsets(offsets, offset_count, sections_[kStopWordText].size, "stop word");
+}
+
+void IndexSnapshot::ValidateDocuments() const {
+    const size_t ordinal_count = GetOrdinalCount();
+    const int* document_ids = GetDocumentIds();
+    const DocumentStatus* statuses = GetStatuses();
+    size_t live_count = 0;
+    for (size_t ordinal = 0; ordinal < ordinal_count; ++ordinal) {
+        live_count += document_ids[ordinal] >= 0 ? 1 : 0;
+        if (static_cast<uint32_t>(statuses[ordinal]) > static_cast<uint32_t>(DocumentStatus::REMOVED)) {
+            throw runtime_error("Index snapshot has an invalid document status");
+        }
+    }
+    const int* sorted_ids = GetSortedDocumentIds();
+    const DocumentOrdinal* sorted_ordinals = GetSection<DocumentOrdinal>(kSortedOrdinals);
+    if (live_count != GetDocumentCount()) {
+        throw runtime_error("Index snapshot document index is inconsistent");
+    }
+    // По картам статусов поиск фильтрует документы, поэтому они должны совпадать со столбцами
+    const size_t word_count = OrdinalBitmap::GetWordCount(ordinal_count);
+    vector<uint64_t> status_words(kDocumentStatusCount * word_count, 0);
+    for (size_t ordinal = 0; ordinal < ordinal_count; ++ordinal) {
+        if (document_ids[ordinal] >= 0) {
+            status_words[static_cast<size_t>(statuses[ordinal]) * word_count + ordinal / 64] |= uint64_t(1) << (ordinal % 64);
+        }
+    }
+    if (!equal(status_words.begin(), status_words.end(), GetSection<uint64_t>(kStatusBitmaps))) {
+        throw runtime_error("Index snapshot status bitmaps are inconsistent");
+    }
+    for (size_t index = 0; index < GetDocumentCount(); ++index) {
+        if (sorted_ids[index] < 0 || (index > 0 && sorted_ids[index] <= sorted_ids[index - 1])
+            || sorted_ordinals[index] >= ordinal_count || document_ids[sorted_ordinals[index]] != sorted_ids[index]) {
+            throw runtime_error("Index snapshot document index is inconsistent");
+        }
+    }
+
+    const uint64_t* forward_offsets = GetForwardOffsets();
+    const size_t forward_size = GetSectionLength(kForwardTermIds, sizeof(TermId));
+    CheckOffsets(forward_offsets, ordinal_count + 1, forward_size, "forward index");
+    const TermId* term_ids = GetForwardTermIds();
+    const uint32_t* term_counts = GetForwardTermCounts();
+    const double* inverse_word_counts = GetInverseWordCounts();
+    for (size_t ordinal = 0; ordinal < ordinal_count; ++ordinal) {
+        // Сумма частот - число слов документа: без этой проверки огромная частота
+        // превращает обход слов документа в многочасовой цикл
+        uint64_t word_count = 0;
+        for (uint64_t i = forward_offsets[ordinal]; i < forward_offsets[ordinal + 1]; ++i) {
+            if (term_ids[i] >= GetTermIdBound() || term_counts[i] == 0) {
+                throw runtime_error("Index snapshot forward index is inconsistent");
+            }
+            word_count += term_counts[i];
+        }
+        if (word_count > 0 && abs(word_count * inverse_word_counts[ordinal] - 1) > 1e-6) {
+            throw runtime_error("Index snapshot forward index is inconsistent");
+        }
+    }
+}
+
+void IndexSnapshot::ValidateTerms() const {
+    const uint64_t* offsets = GetSection<uint64_t>(kTermOffsets);
+    CheckOffsets(offsets, GetTermIdBound() + size_t(1), sections_[kTermText].size, "term");
+    const uint32_t* table = GetSection<uint32_t>(kTermTable);
+    for (size_t index = 0; index < GetSectionLength(kTermTable, sizeof(uint32_t)); ++index) {
+        if (table[index] > GetTermIdBound()) {
+            throw runtime_error("Index snapshot term table is inconsistent");
+        }
+    }
+    // Неверная граница вклада слова молча отсекла бы документы в WAND
+    const TermBounds* bounds = GetTermBounds();
+    for (TermId term_id = 0; term_id < GetTermIdBound(); ++term_id) {
+        const TermBounds& term_bounds = bounds[term_id];
+        if (!(term_bounds.log_document_freq >= 0 && isfinite(term_bounds.log_document_freq)
+              && term_bounds.max_term_freq >= 0 && term_bounds.max_term_freq <= 1 + 1e-9)) {
+            throw runtime_error("Index snapshot term statistics are inconsistent");
+        }
+    }
+}
+
+void IndexSnapshot::ValidatePostings() const {
+    const PostingDirectoryEntry* directory = GetSection<PostingDirectoryEntry>(kPostingDirectory);
+    const size_t block_count = GetSectionLength(kPostingBlocks, sizeof(PostingBlock));
+    const size_t data_size = sections_[kPostingData].size;
+    const size_t tail_count = GetSectionLength(kPostingTailOrdinals, sizeof(DocumentOrdinal));
+    const DocumentOrdinal ordinal_count = GetOrdinalCount();
+    if (GetSectionLength(kPostingTailCounts, sizeof(uint32_t)) != tail_count) {
+        throw runtime_error("Index snapshot posting sections are inconsistent");
+    }
+    const auto fail = [] {
+        throw runtime_error("Index snapshot posting list is inconsistent");
+    };
+
+    DocumentOrdinal ordinals[kPostingBlockSize];
+    uint32_t counts[kPostingBlockSize];
+    for (TermId term_id = 0; term_id < GetTermIdBound(); ++term_id) {
+        const PostingDirectoryEntry& entry = directory[term_id];
+        if (entry.first_block > block_count || entry.block_count > block_count - entry.first_block
+            || entry.first_tail > tail_count || entry.tail_size > tail_count - entry.first_tail
+            || entry.data_offset > data_size) {
+            fail();
+        }
+        // Блоки распаковываются целиком: номера должны расти внутри блока и между блоками
+        // и не выходить за число документов, иначе они станут индексами за концом столбцов
+        const PostingBlock* blocks = GetSection<PostingBlock>(kPostingBlocks) + entry.first_block;
+        const uint8_t* data = GetSection<uint8_t>(kPostingData) + entry.data_offset;
+        const size_t term_data_size = data_size - entry.data_offset;
+        uint64_t size = 0;
+        int64_t last_ordinal = -1;
+        for (size_t index = 0; index < entry.block_count; ++index) {
+            const PostingBlock& block = blocks[index];
+            const auto is_width = [](uint8_t width) {
+                return width == 1 || width == 2 || width == 4;
+            };
+            if (block.size == 0 || block.size > kPostingBlockSize || !is_width(block.delta_width) || !is_width(block.count_width)
+                || block.offset > term_data_size
+                || size_t(block.size) * (block.delta_width + block.count_width) > term_data_size - block.offset
+                || static_cast<int64_t>(block.first_ordinal) <= last_ordinal || block.last_ordinal >= ordinal_count) {
+                fail();
+            }
+            PostingListView::DecodeBlock(block, data, ordinals, counts);
+            if (ordinals[0] != block.first_ordinal || ordinals[block.size - 1] != block.last_ordinal) {
+                fail();
+            }
+            for (size_t i = 0; i < block.size; ++i) {
+                if ((i > 0 && ordinals[i] <= ordinals[i - 1]) || counts[i] == 0) {
+                    fail();
+                }
+            }
+            last_ordinal = block.last_ordinal;
+            size += block.size;
+        }
+        const DocumentOrdinal* tail_ordinals = GetSection<DocumentOrdinal>(kPostingTailOrdinals) + entry.first_tail;
+        const uint32_t* tail_counts = GetSection<uint32_t>(kPostingTailCounts) + entry.first_tail;
+        for (size_t i = 0; i < entry.tail_size; ++i) {
+            if (static_cast<int64_t>(tail_ordinals[i]) <= last_ordinal || tail_ordinals[i] >= ordinal_count || tail_counts[i] == 0) {
+                fail();
+            }
+            last_ordinal = tail_ordinals[i];
+        }
+        if (entry.size != size + entry.tail_size) {
+            fail();
+        }
+    }
+}
+
+void IndexSnapshot::CheckOffsets(const uint64_t* offsets, size_t count, size_t bound, const string& name) {
+    // Смещения начинаются с нуля, не убывают и заканчиваются на размере своей секции
+    if (count == 0 || offsets[0] != 0 || offsets[count - 1] != bound) {
+        throw runtime_error("Index snapshot " + name + " offsets are inconsistent");
+    }
+    for (size_t i = 1; i < count; ++i) {
+        if (offsets[i] < offsets[i - 1]) {
+            throw runtime_error("Index snapshot " + name + " offsets are inconsistent");
+        }
+    }
+}
+
+template <typename T>
+const T* IndexSnapshot::GetSection(size_t index) const {
+    return static_cast<const T*>(sections_[index].data);
+}
+
+size_t IndexSnapshot::GetSectionLength(size_t index, size_t element_size) const {
+    return sections_[index].size / element_size;
+}
+
+vector<string_view> IndexSnapshot::GetStopWords() const {
+    const uint64_t* offsets = GetSection<uint64_t>(kStopWordOffsets);
+    const char* text = GetSection<char>(kStopWordText);
+    vector<string_view> stop_words;
+    for (size_t i = 0; i + 1 < GetSectionLength(kStopWordOffsets, sizeof(uint64_t)); ++i) {
+        stop_words.emplace_back(text + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    return stop_words;
+}
+
+size_t IndexSnapshot::GetOrdinalCount() const {
+    return GetSectionLength(kDocumentIds, sizeof(int));
+}
+
+size_t IndexSnapshot::GetDocumentCount() const {
+    return GetSectionLength(kSortedDocumentIds, sizeof(int));
+}
+
+const int* IndexSnapshot::GetDocumentIds() const {
+    return GetSection<int>(kDocumentIds);
+}
+
+const int* IndexSnapshot::GetRatings() const {
+    return GetSection<int>(kRatings);
+}
+
+const DocumentStatus* IndexSnapshot::GetStatuses() const {
+    return GetSection<DocumentStatus>(kStatuses);
+}
+
+const double* IndexSnapshot::GetInverseWordCounts() const {
+    return GetSection<double>(kInverseWordCounts);
+}
+
+const uint64_t* IndexSnapshot::GetForwardOffsets() const {
+    return GetSection<uint64_t>(kForwardOffsets);
+}
+
+const TermId* IndexSnapshot::GetForwardTermIds() const {
+    return GetSection<TermId>(kForwardTermIds);
+}
+
+const uint32_t* IndexSnapshot::GetForwardTermCounts() const {
+    return GetSection<uint32_t>(kForwardTermCounts);
+}
+
+const uint64_t* IndexSnapshot::GetStatusBitmap(DocumentStatus status) const {
+    return GetSection<uint64_t>(kStatusBitmaps) + static_cast<size_t>(status) * OrdinalBitmap::GetWordCount(GetOrdinalCount());
+}
+
+const int* IndexSnapshot::GetSortedDocumentIds() const {
+    return GetSection<int>(kSortedDocumentIds);
+}
+
+DocumentOrdinal IndexSnapshot::FindOrdinal(int document_id) const {
+    const int* ids_begin = GetSortedDocumentIds();
+    const int* ids_end = ids_begin + GetDocumentCount();
+    const int* it = lower_bound(ids_begin, ids_end, document_id);
+    if (it == ids_end || *it != document_id) {
+        return kNoOrdinal;
+    }
+    return GetSection<DocumentOrdinal>(kSortedOrdinals)[it - ids_begin];
+}
+
+TermId IndexSnapshot::GetTermIdBound() const {
+    return GetSectionLength(kTermOffsets, sizeof(uint64_t)) - 1;
+}
+
+TermId IndexSnapshot::FindTerm(string_view term) const {
+    const uint32_t* table = GetSection<uint32_t>(kTermTable);
+    const size_t table_size = GetSectionLength(kTermTable, sizeof(uint32_t));
+    size_t index = HashTerm(term) & (table_size - 1);
+    for (size_t probe = 0; probe < table_size && table[index] != 0; ++probe) {
+        const TermId term_id = table[index] - 1;
+        if (term_id < GetTermIdBound() && GetTerm(term_id) == term) {
+            return term_id;
+        }
+        index = (index + 1) & (table_size - 1);
+    }
+    return TermDictionary::kNoTerm;
+}
+
+string_view IndexSnapshot::GetTerm(TermId term_id) const {
+    const uint64_t* offsets = GetSection<uint64_t>(kTermOffsets);
+    return {GetSection<char>(kTermText) + offsets[term_id], offsets[term_id + 1] - offsets[term_id]};
+}
+
+PostingListView IndexSnapshot::GetPostings(TermId term_id) const {
+    const PostingDirectoryEntry& entry = GetSection<PostingDirectoryEntry>(kPostingDirectory)[term_id];
+    return PostingListView(GetSection<PostingBlock>(kPostingBlocks) + entry.first_block, entry.block_count,
+                           GetSection<uint8_t>(kPostingData) + entry.data_offset,
+                           GetSection<DocumentOrdinal>(kPostingTailOrdinals) + entry.first_tail,
+                           GetSection<uint32_t>(kPostingTailCounts) + entry.first_tail,
+                           entry.tail_size, entry.size);
+}
+
+const TermBounds* IndexSnapshot::GetTermBounds() const {
+    return GetSection<TermBounds>(kTermBounds);
+}
+
+size_t IndexSnapshot::GetFileSize() const {
+    return mapping_size_;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+#include "ordinal_bitmap.h"
+#include "posting_list.h"
+#include "term_dictionary.h"
+
+// Версия двоичного формата снимка; меняется при любом изменении раскладки секций
+const uint32_t kSnapshotVersion = 3;
+
+// Содержимое индекса для записи в снимок. Массивы документов индексируются
+// порядковым номером, удалённые документы имеют id == -1
+struct SnapshotContent {
+    std::vector<std::string_view> stop_words;
+    size_t ordinal_count = 0;
+    const int* document_ids = nullptr;
+    const int* ratings = nullptr;
+    const DocumentStatus* statuses = nullptr;
+    const double* inverse_word_counts = nullptr;
+    // Прямой индекс: термы документа ordinal лежат в [forward_offsets[ordinal], forward_offsets[ordinal + 1])
+    const uint64_t* forward_offsets = nullptr;
+    const TermId* forward_term_ids = nullptr;
+    const uint32_t* forward_term_counts = nullptr;
+    // Слова битовых карт статусов (по карте на каждый DocumentStatus), в каждой
+    // OrdinalBitmap::GetWordCount(ordinal_count) слов
+    std::array<const uint64_t*, kDocumentStatusCount> status_bitmaps{};
+    // Текст и список вхождений по идентификатору терма; пустая строка - свободный идентификатор
+    std::vector<std::string_view> terms;
+    std::vector<PostingListView> postings;
+    // Статистика термов, terms.size() элементов
+    const TermBounds* term_bounds = nullptr;
+};
+
+// Записывает снимок во временный файл и атомарно переименовывает его в path.
+// К возврату и содержимое, и переименование сохранены на диске
+void WriteIndexSnapshot(const std::string& path, const SnapshotContent& content);
+
+// Снимок индекса, отображённый в память только для чтения. Все массивы
+// возвращаются указателями прямо в отображение и живут, пока жив снимок.
+class IndexSnapshot {
+public:
+    static const DocumentOrdinal kNoOrdinal = std::numeric_limits<DocumentOrdinal>::max();
+
+    // Всегда проверяет заголовок, таблицу секций и длины секций - это не зависит от размера
+    // индекса. Полная контрольная сумма считается только при verify_checksum, а обход всех
+    // данных (смещения, номера документов, идентификаторы термов, списки вхождений, карты
+    // статусов) - только при verify_structure: без них файл считается записанным
+    // WriteIndexSnapshot. Повреждённый файл - runtime_error
+    static std::shared_ptr<const IndexSnapshot> Open(const std::string& path, bool verify_checksum, bool verify_structure);
+
+    IndexSnapshot(const IndexSnapshot&) = delete;
+    IndexSnapshot& operator=(const IndexSnapshot&) = delete;
+    ~IndexSnapshot();
+
+    std::vector<std::string_view> GetStopWords() const;
+
+    size_t GetOrdinalCount() const;
+    size_t GetDocumentCount() const;
+    const int* GetDocumentIds() const;
+    const int* GetRatings() const;
+    const DocumentStatus* GetStatuses() const;
+    const double* GetInverseWordCounts() const;
+    const uint64_t* GetForwardOffsets() const;
+    const TermId* GetForwardTermIds() const;
+    const uint32_t* GetForwardTermCounts() const;
+    const uint64_t* GetStatusBitmap(DocumentStatus status) const;
+    // Идентификаторы живых документов по возрастанию
+    const int* GetSortedDocumentIds() const;
+    DocumentOrdinal FindOrdinal(int document_id) const;
+
+    TermId GetTermIdBound() const;
+    TermId FindTerm(std::string_view term) const;
+    std::string_view GetTerm(TermId term_id) const;
+    PostingListView GetPostings(TermId term_id) const;
+    const TermBounds* GetTermBounds() const;
+
+    size_t GetFileSize() const;
+
+private:
+    struct Section {
+        const void* data = nullptr;
+        size_t size = 0;
+    };
+
+    const uint8_t* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    // Без mmap файл целиком читается в этот буфер
+    std::vector<uint64_t> buffer_;
+    std::vector<Section> sections_;
+
+    IndexSnapshot() = default;
+
+    void Map(const std::string& path);
+    void Validate(bool verify_checksum, bool verify_structure);
+    void ValidateStopWords() const;
+    void ValidateDocuments() const;
+    void ValidateTerms() const;
+    void ValidatePostings() const;
+    static void CheckOffsets(const uint64_t* offsets, size_t count, size_t bound, const std::string& name);
+
+    template <typename T>
+    const T* GetSection(size_t index) const;
+    size_t GetSectionLength(size_t index, size_t element_size) const;
+};
@@ -0,0 +1,87 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+size_t LatencyDistribution::GetBucketIndex(uint64_t nanoseconds) {
+    if (nanoseconds < 2 * kSubBucketCount) {
+        return nanoseconds;
+    }
+    // Сдвиг, после которого в значении остаётся kSubBucketBits + 1 значащих битов
+    const size_t shift = 63 - __builtin_clzll(nanoseconds) - kSubBucketBits;
+    if (shift > kMaxShift) {
+        return kBucketCount - 1;
+    }
+    return shift * kSubBucketCount + (nanoseconds >> shift);
+}
+
+uint64_t LatencyDistribution::GetBucketUpperBound(size_t index) {
+    if (index < 2 * kSubBucketCount) {
+        return index;
+    }
+    const size_t shift = index / kSubBucketCount - 1;
+    const uint64_t lower_bound = (index % kSubBucketCount + kSubBucketCount) << shift;
+    return lower_bound + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyDistribution::Add(uint64_t nanoseconds, uint64_t count) {
+    AddBucket(GetBucketIndex(nanoseconds), count);
+}
+
+void LatencyDistribution::AddBucket(size_t index, uint64_t count) {
+    counts_[index] += count;
+    count_ += count;
+}
+
+void LatencyDistribution::Merge(const LatencyDistribution& other) {
+    for (size_t index = 0; index < kBucketCount; ++index) {
+        counts_[index] += other.counts_[index];
+    }
+    count_ += other.count_;
+}
+
+uint64_t LatencyDistribution::GetCount() const {
+    return count_;
+}
+
+chrono::nanoseconds LatencyDistribution::GetPercentile(double percentile) const {
+    if (count_ == 0) {
+        return chrono::nanoseconds(0);
+    }
+    // Номер значения по возрастанию, начиная с 1
+    const uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(ceil(percentile / 100 * count_)));
+    uint64_t seen = 0;
+    for (size_t index = 0; index < kBucketCount; ++index) {
+        seen += counts_[index];
+        if (seen >= rank) {
+            return chrono::nanoseconds(GetBucketUpperBound(index));
+        }
+    }
+    return GetMax();
+}
+
+chrono::nanoseconds LatencyDistribution::GetMax() const {
+    for (size_t index = kBucketCount; index > 0; --index) {
+        if (counts_[index - 1] > 0) {
+            return chrono::nanoseconds(GetBucketUpperBound(index - 1));
+        }
+    }
+    return chrono::nanoseconds(0);
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& count : counts_) {
+        count.store(0, memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::AddTo(LatencyDistribution& distribution) const {
+    for (size_t index = 0; index < LatencyDistribution::kBucketCount; ++index) {
+        const uint64_t count = counts_[index].load(memory_order_relaxed);
+        if (count > 0) {
+            distribution.AddBucket(index, count);
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Распределение задержек в наносекундах в духе HDR-гистограмм: до 64 нс интервалы единичные,
+// дальше каждый отрезок [2^k, 2^(k+1)) делится на 32 равных интервала, поэтому значение
+// восстанавливается с погрешностью не больше 1/32. Значения от 2^42 нс (~73 минуты)
+// попадают в последний интервал
+class LatencyDistribution {
+public:
+    static const size_t kSubBucketBits = 5;
+    static const size_t kSubBucketCount = size_t(1) << kSubBucketBits;
+    static const size_t kMaxShift = 36;
+    static const size_t kBucketCount = (kMaxShift + 2) * kSubBucketCount;
+
+    static size_t GetBucketIndex(uint64_t nanoseconds);
+    // Наибольшее значение, попадающее в интервал
+    static uint64_t GetBucketUpperBound(size_t index);
+
+    void Add(uint64_t nanoseconds, uint64_t count = 1);
+    void AddBucket(size_t index, uint64_t count);
+    void Merge(const LatencyDistribution& other);
+
+    uint64_t GetCount() const;
+    // Задержка, которую не превышают percentile процентов значений (с точностью до интервала)
+    std::chrono::nanoseconds GetPercentile(double percentile) const;
+    std::chrono::nanoseconds GetMax() const;
+
+private:
+    std::array<uint64_t, kBucketCount> counts_{};
+    uint64_t count_ = 0;
+};
+
+// Та же гистограмма с атомарными счётчиками: потоки записывают значения без блокировок
+class LatencyHistogram {
+public:
+    void Record(std::chrono::nanoseconds latency) {
+        const int64_t nanoseconds = latency.count();
+        counts_[LatencyDistribution::GetBucketIndex(nanoseconds > 0 ? nanoseconds : 0)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Обнуление не согласовано с параллельными Record: их значения могут потеряться
+    void Reset();
+    void AddTo(LatencyDistribution& distribution) const;
+
+private:
+    std::array<std::atomic<uint64_t>, LatencyDistribution::kBucketCount> counts_{};
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Массив, который либо владеет элементами, либо ссылается на чужую память
+// (например, на отображённый в память файл снимка индекса). Чтение одинаково
+// в обоих режимах; первое изменение копирует элементы в собственный буфер.
+template <typename T>
+class MappedVector {
+public:
+    MappedVector() = default;
+
+    MappedVector(const T* data, size_t size)
+        : view_(data)
+        , view_size_(size)
+        , is_view_(true) {}
+
+    size_t size() const {
+        return is_view_ ? view_size_ : owned_.size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    const T* data() const {
+        return is_view_ ? view_ : owned_.data();
+    }
+
+    const T* begin() const {
+        return data();
+    }
+
+    const T* end() const {
+        return data() + size();
+    }
+
+    const T& operator[](size_t index) const {
+        return data()[index];
+    }
+
+    const T& back() const {
+        return data()[size() - 1];
+    }
+
+    bool IsView() const {
+        return is_view_;
+    }
+
+    void Set(size_t index, const T& value) {
+        Detach();
+        owned_[index] = value;
+    }
+
+    void push_back(const T& value) {
+        Detach();
+        owned_.push_back(value);
+    }
+
+    void resize(size_t size) {
+        Detach();
+        owned_.resize(size);
+    }
+
+    void Assign(std::vector<T> values) {
+        owned_ = std::move(values);
+        view_ = nullptr;
+        view_size_ = 0;
+        is_view_ = false;
+    }
+
+    void Detach() {
+        if (is_view_) {
+            owned_.assign(view_, view_ + view_size_);
+            view_ = nullptr;
+            view_size_ = 0;
+            is_view_ = false;
+        }
+    }
+
+private:
+    std::vector<T> owned_;
+    const T* view_ = nullptr;
+    size_t view_size_ = 0;
+    bool is_view_ = false;
+};
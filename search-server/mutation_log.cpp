@@ -0,0 +1,481 @@
+#include "mutation_log.h"
+#include "checksum.h"
+#include "search_server.h"
+
+#include <algorithm>
+#include <cstring>
+#include <execution>
+#include <functional>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define MUTATION_LOG_USE_FSYNC 1
+#endif
+
+using namespace std;
+
+namespace {
+
+// Файл: заголовок, затем записи {размер данных, тип, контрольная сумма типа и данных, данные}
+struct LogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+};
+
+struct RecordHeader {
+    uint32_t size;
+    uint32_t type;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(LogHeader) == 16 && sizeof(RecordHeader) == 16, "Log structures must not contain implicit padding");
+
+const char kLogMagic[8] = {'S', 'R', 'C', 'H', 'W', 'A', 'L', '\0'};
+const uint32_t kLogVersion = 1;
+const uint32_t kByteOrderMark = 0x01020304;
+
+enum RecordType : uint32_t {
+    kAddDocument = 1,
+    kRemoveDocuments = 2,
+};
+
+template <typename T>
+void Put(string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void PutRecordHeader(string& out, uint32_t type, size_t payload_offset) {
+    RecordHeader header{static_cast<uint32_t>(out.size() - payload_offset), type, 0};
+    Checksum checksum;
+    checksum.Update(&type, sizeof(type));
+    checksum.Update(out.data() + payload_offset, header.size);
+    header.checksum = checksum.Get();
+    memcpy(out.data() + payload_offset - sizeof(RecordHeader), &header, sizeof(header));
+}
+
+// Последовательное чтение данных записи с проверкой границ
+class RecordReader {
+public:
+    RecordReader(const char* data, size_t size) : data_(data), left_(size) {}
+
+    template <typename T>
+    T Get() {
+        T value;
+        memcpy(&value, Take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    const char* Take(size_t size) {
+        if (size > left_) {
+            throw invalid_argument("Malformed mutation log record");
+        }
+        const char* result = data_;
+        data_ += size;
+        left_ -= size;
+        return result;
+    }
+
+private:
+    const char* data_;
+    size_t left_;
+};
+
+struct Mutation {
+    RecordType type = kAddDocument;
+    int document_id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    vector<int> ratings;
+    string_view document;
+    vector<int> removed_ids;
+};
+
+struct RecordSpan {
+    uint32_t type;
+    uint64_t checksum;
+    const char* payload;
+    uint32_t size;
+};
+
+string ReadFile(const string& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void CheckHeader(const string& content) {
+    LogHeader header;
+    if (content.size() < sizeof(header)) {
+        throw invalid_argument("Mutation log is truncated");
+    }
+    memcpy(&header, content.data(), sizeof(header));
+    if (memcmp(header.magic, kLogMagic, sizeof(kLogMagic)) != 0 || header.byte_order != kByteOrderMark) {
+        throw invalid_argument("File is not a mutation log");
+    }
+    if (header.version != kLogVersion) {
+        throw invalid_argument("Unsupported mutation log version " + to_string(header.version));
+    }
+}
+
+// Границы записей; последняя запись, не поместившаяся в файл целиком, отбрасывается
+vector<RecordSpan> SplitRecords(const string& content) {
+    vector<RecordSpan> records;
+    size_t offset = sizeof(LogHeader);
+    while (content.size() - offset >= sizeof(RecordHeader)) {
+        RecordHeader header;
+        memcpy(&header, content.data() + offset, sizeof(header));
+        if (header.size > content.size() - offset - sizeof(RecordHeader)) {
+            break;
+        }
+        records.push_back({header.type, header.checksum, content.data() + offset + sizeof(RecordHeader), header.size});
+        offset += sizeof(RecordHeader) + header.size;
+    }
+    return records;
+}
+
+bool DecodeRecord(const RecordSpan& record, Mutation& mutation) {
+    Checksum checksum;
+    checksum.Update(&record.type, sizeof(record.type));
+    checksum.Update(record.payload, record.size);
+    if (checksum.Get() != record.checksum) {
+        return false;
+    }
+    RecordReader reader(record.payload, record.size);
+    mutation.type = static_cast<RecordType>(record.type);
+    if (record.type == kAddDocument) {
+        mutation.document_id = reader.Get<int32_t>();
+        mutation.status = static_cast<DocumentStatus>(reader.Get<int32_t>());
+        mutation.ratings.resize(reader.Get<uint32_t>());
+        for (int& rating : mutation.ratings) {
+            rating = reader.Get<int32_t>();
+        }
+        const uint32_t document_size = reader.Get<uint32_t>();
+        mutation.document = string_view(reader.Take(document_size), document_size);
+        return true;
+    }
+    if (record.type == kRemoveDocuments) {
+        mutation.removed_ids.resize(reader.Get<uint32_t>());
+        for (int& document_id : mutation.removed_ids) {
+            document_id = reader.Get<int32_t>();
+        }
+        return true;
+    }
+    return false;
+}
+
+// Разбирает записи параллельно; результат обрывается на первой повреждённой записи
+vector<Mutation> DecodeRecords(const string& content) {
+    const vector<RecordSpan> records = SplitRecords(content);
+    vector<Mutation> mutations(records.size());
+    vector<size_t> indexes(records.size());
+    iota(indexes.begin(), indexes.end(), 0);
+    vector<char> decoded(records.size());
+    for_each(execution::par, indexes.begin(), indexes.end(), [&](size_t index) {
+        try {
+            decoded[index] = DecodeRecord(records[index], mutations[index]);
+        } catch (const invalid_argument&) {
+            decoded[index] = false;
+        }
+    });
+    const size_t valid_count = find(decoded.begin(), decoded.end(), false) - decoded.begin();
+    mutations.resize(valid_count);
+    return mutations;
+}
+
+size_t GetRecordsSize(const vector<Mutation>& mutations, const string& content) {
+    const vector<RecordSpan> records = SplitRecords(content);
+    if (mutations.empty()) {
+        return sizeof(LogHeader);
+    }
+    const RecordSpan& last = records[mutations.size() - 1];
+    return last.payload + last.size - content.data();
+}
+
+} // namespace
+
+MutationLog::MutationLog(const string& path, MutationLogOptions options)
+    : path_(path)
+    , options_(options) {
+    const string content = ReadFile(path_);
+    if (content.empty()) {
+        file_ = CreateLogFile(MakeHeader());
+    } else {
+        CheckHeader(content);
+        const size_t valid_size = GetRecordsSize(DecodeRecords(content), content);
+        if (valid_size < content.size()) {
+            // Хвост после падения посреди записи отрезается, чтобы дозапись шла за целыми записями
+#ifdef MUTATION_LOG_USE_FSYNC
+            file_ = fopen(path_.c_str(), "r+b");
+            if (file_ == nullptr || ftruncate(fileno(file_), valid_size) != 0 || fseek(file_, 0, SEEK_END) != 0
+                || (options_.fsync && fsync(fileno(file_)) != 0)) {
+                if (file_ != nullptr) {
+                    fclose(file_);
+                }
+                throw runtime_error("Failed to repair mutation log " + path_);
+            }
+#else
+            file_ = CreateLogFile(content.substr(0, valid_size));
+#endif
+        } else {
+            file_ = fopen(path_.c_str(), "ab");
+            if (file_ == nullptr) {
+                throw runtime_error("Failed to open mutation log " + path_);
+            }
+        }
+    }
+    flusher_ = thread([this] { FlushLoop(); });
+}
+
+MutationLog::~MutationLog() {
+    {
+        lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    flush_requested_.notify_one();
+    flusher_.join();
+    fclose(file_);
+}
+
+uint64_t MutationLog::LogAdd(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    static thread_local string record;
+    record.assign(sizeof(RecordHeader), '\0');
+    Put<int32_t>(record, document_id);
+    Put<int32_t>(record, static_cast<int32_t>(status));
+    Put<uint32_t>(record, ratings.size());
+    for (const int rating : ratings) {
+        Put<int32_t>(record, rating);
+    }
+    Put<uint32_t>(record, document.size());
+    record.append(document);
+    PutRecordHeader(record, kAddDocument, sizeof(RecordHeader));
+    return Append(record);
+}
+
+uint64_t MutationLog::LogRemove(const vector<int>& document_ids) {
+    static thread_local string record;
+    record.assign(sizeof(RecordHeader), '\0');
+    Put<uint32_t>(record, document_ids.size());
+    for (const int document_id : document_ids) {
+        Put<int32_t>(record, document_id);
+    }
+    PutRecordHeader(record, kRemoveDocuments, sizeof(RecordHeader));
+    return Append(record);
+}
+
+uint64_t MutationLog::Append(const string& record) {
+    uint64_t sequence;
+    bool batch_full;
+    {
+        unique_lock lock(mutex_);
+        appends_resumed_.wait(lock, [this] { return !appends_blocked_; });
+        pending_ += record;
+        ++pending_records_;
+        ++stats_.records;
+        stats_.bytes += record.size();
+        sequence = ++appended_sequence_;
+        batch_full = pending_records_ >= options_.sync_batch_records;
+    }
+    if (batch_full) {
+        flush_requested_.notify_one();
+    }
+    return sequence;
+}
+
+void MutationLog::WaitDurable(uint64_t sequence) {
+    unique_lock lock(mutex_);
+    if (durable_sequence_ < sequence) {
+        flush_now_ = true;
+        flush_requested_.notify_one();
+        durable_.wait(lock, [this, sequence] { return durable_sequence_ >= sequence || failed_; });
+    }
+    if (failed_) {
+        throw runtime_error("Failed to write mutation log " + path_);
+    }
+}
+
+void MutationLog::Sync() {
+    uint64_t sequence;
+    {
+        lock_guard lock(mutex_);
+        sequence = appended_sequence_;
+    }
+    WaitDurable(sequence);
+}
+
+void MutationLog::Truncate() {
+    Checkpoint({});
+}
+
+void MutationLog::Checkpoint(const function<void()>& save_snapshot) {
+    {
+        unique_lock lock(mutex_);
+        appends_resumed_.wait(lock, [this] { return !appends_blocked_; });
+        appends_blocked_ = true;
+    }
+    // Дозапись возобновляется при любом исходе, в том числе при исключении
+    const auto resume_appends = [this] {
+        {
+            lock_guard lock(mutex_);
+            appends_blocked_ = false;
+        }
+        appends_resumed_.notify_all();
+    };
+    try {
+        Sync();
+        if (save_snapshot) {
+            save_snapshot();
+        }
+        // Новый журнал готовится рядом и подменяет старый переименованием;
+        // старый файл остаётся открытым, пока замена не удалась
+        FILE* file = CreateLogFile(MakeHeader());
+        lock_guard file_lock(file_mutex_);
+        fclose(file_);
+        file_ = file;
+    } catch (...) {
+        resume_appends();
+        throw;
+    }
+    resume_appends();
+}
+
+MutationLogStats MutationLog::GetStats() const {
+    lock_guard lock(mutex_);
+    return stats_;
+}
+
+string MutationLog::MakeHeader() {
+    LogHeader header{};
+    memcpy(header.magic, kLogMagic, sizeof(kLogMagic));
+    header.version = kLogVersion;
+    header.byte_order = kByteOrderMark;
+    return string(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+FILE* MutationLog::CreateLogFile(const string& content) const {
+    const string temporary_path = path_ + ".tmp";
+    FILE* file = fopen(temporary_path.c_str(), "wb");
+    if (file == nullptr) {
+        throw runtime_error("Failed to create mutation log " + temporary_path);
+    }
+    bool written = fwrite(content.data(), 1, content.size(), file) == content.size() && fflush(file) == 0;
+#ifdef MUTATION_LOG_USE_FSYNC
+    if (written && options_.fsync) {
+        written = fsync(fileno(file)) == 0;
+    }
+#endif
+    if (!written || rename(temporary_path.c_str(), path_.c_str()) != 0) {
+        fclose(file);
+        remove(temporary_path.c_str());
+        throw runtime_error("Failed to write mutation log " + path_);
+    }
+#ifdef MUTATION_LOG_USE_FSYNC
+    // Переименование должно пережить сбой ОС так же, как и сами записи
+    if (options_.fsync) {
+        const size_t slash = path_.find_last_of('/');
+        const string directory = slash == string::npos ? "." : slash == 0 ? "/" : path_.substr(0, slash);
+        const int descriptor = open(directory.c_str(), O_RDONLY);
+        const bool synced = descriptor >= 0 && fsync(descriptor) == 0;
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+        if (!synced) {
+            fclose(file);
+            throw runtime_error("Failed to sync directory of mutation log " + path_);
+        }
+    }
+#endif
+    return file;
+}
+
+void MutationLog::FlushLoop() {
+    unique_lock lock(mutex_);
+    while (true) {
+        flush_requested_.wait_for(lock, options_.sync_interval, [this] {
+            return stopping_ || flush_now_ || pending_records_ >= options_.sync_batch_records;
+        });
+        if (pending_.empty()) {
+            flush_now_ = false;
+            durable_.notify_all();
+            if (stopping_) {
+                return;
+            }
+            continue;
+        }
+        string batch;
+        batch.swap(pending_);
+        pending_records_ = 0;
+        flush_now_ = false;
+        const uint64_t sequence = appended_sequence_;
+        lock.unlock();
+
+        const auto start = chrono::steady_clock::now();
+        bool written;
+        {
+            lock_guard file_lock(file_mutex_);
+            written = fwrite(batch.data(), 1, batch.size(), file_) == batch.size() && fflush(file_) == 0;
+#ifdef MUTATION_LOG_USE_FSYNC
+            if (written && options_.fsync) {
+                written = fdatasync(fileno(file_)) == 0;
+            }
+#endif
+        }
+        const auto sync_time = chrono::steady_clock::now() - start;
+
+        lock.lock();
+        if (written) {
+            durable_sequence_ = sequence;
+        } else {
+            failed_ = true;
+        }
+        ++stats_.syncs;
+        stats_.sync_time += chrono::duration_cast<chrono::nanoseconds>(sync_time);
+        durable_.notify_all();
+    }
+}
+
+size_t MutationLog::Replay(const string& path, SearchServer& server) {
+    const string content = ReadFile(path);
+    if (content.empty()) {
+        return 0;
+    }
+    CheckHeader(content);
+    const vector<Mutation> mutations = DecodeRecords(content);
+
+    // Итог для каждого затронутого документа определяется последней записью о нём:
+    // затронутые документы удаляются разом, затем добавляются последние версии
+    unordered_map<int, size_t> last_mutation;
+    for (size_t index = 0; index < mutations.size(); ++index) {
+        const Mutation& mutation = mutations[index];
+        if (mutation.type == kAddDocument) {
+            last_mutation[mutation.document_id] = index;
+        } else {
+            for (const int document_id : mutation.removed_ids) {
+                last_mutation[document_id] = index;
+            }
+        }
+    }
+    vector<int> touched_ids;
+    vector<size_t> added;
+    touched_ids.reserve(last_mutation.size());
+    for (const auto& [document_id, index] : last_mutation) {
+        touched_ids.push_back(document_id);
+        if (mutations[index].type == kAddDocument) {
+            added.push_back(index);
+        }
+    }
+    server.RemoveDocuments(execution::par, touched_ids);
+    sort(added.begin(), added.end());
+    vector<NewDocument> documents;
+    documents.reserve(added.size());
+    for (const size_t index : added) {
+        const Mutation& mutation = mutations[index];
+        documents.push_back({mutation.document_id, mutation.document, mutation.status, mutation.ratings});
+    }
+    server.AddDocuments(execution::par, documents);
+    return mutations.size();
+}
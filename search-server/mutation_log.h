@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "document.h"
+
+class SearchServer;
+
+struct MutationLogOptions {
+    // Фоновый сброс начинается, как только накопится столько записей...
+    size_t sync_batch_records = 256;
+    // ...или истечёт этот интервал с момента предыдущего сброса
+    std::chrono::milliseconds sync_interval{10};
+    // false - данные только передаются ОС без fsync (переживают падение процесса, но не ОС)
+    bool fsync = true;
+};
+
+struct MutationLogStats {
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t syncs = 0;
+    std::chrono::nanoseconds sync_time{0};
+};
+
+// Журнал изменений индекса (write-ahead log) с групповой фиксацией.
+// Запись в журнал только копирует её в буфер; буфер пишется в файл и
+// синхронизируется фоновым потоком пачками, поэтому добавление документов
+// не ждёт диска. Кому нужна гарантия сохранности, ждёт её через WaitDurable/Sync.
+class MutationLog {
+public:
+    // Открывает журнал для дозаписи; оборванная при падении последняя запись отбрасывается
+    explicit MutationLog(const std::string& path, MutationLogOptions options = {});
+    MutationLog(const MutationLog&) = delete;
+    MutationLog& operator=(const MutationLog&) = delete;
+    ~MutationLog();
+
+    // Возвращают порядковый номер записи для WaitDurable
+    uint64_t LogAdd(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    uint64_t LogRemove(const std::vector<int>& document_ids);
+
+    void WaitDurable(uint64_t sequence);
+    // Дожидается сохранности всех записанных к этому моменту записей
+    void Sync();
+    // Очищает журнал, например после того как его изменения вошли в свежий снимок
+    void Truncate();
+    // Сохраняет все записи, вызывает save_snapshot и очищает журнал. Новые записи
+    // ждут до конца, поэтому ни одна из них не теряется между снимком и очисткой.
+    // При исключении журнал остаётся прежним
+    void Checkpoint(const std::function<void()>& save_snapshot);
+
+    MutationLogStats GetStats() const;
+
+    // Применяет журнал к server: записи проверяются и разбираются параллельно, затем
+    // сворачиваются до последнего изменения каждого документа, поэтому повторное
+    // применение того же журнала даёт тот же индекс. Возвращает число записей
+    static size_t Replay(const std::string& path, SearchServer& server);
+
+private:
+    std::string path_;
+    MutationLogOptions options_;
+    std::FILE* file_ = nullptr;
+
+    mutable std::mutex mutex_;
+    std::condition_variable flush_requested_;
+    std::condition_variable durable_;
+    // Записи, ещё не переданные в файл
+    std::string pending_;
+    size_t pending_records_ = 0;
+    uint64_t appended_sequence_ = 0;
+    uint64_t durable_sequence_ = 0;
+    bool flush_now_ = false;
+    bool stopping_ = false;
+    bool failed_ = false;
+    // Дозапись приостановлена на время Checkpoint
+    bool appends_blocked_ = false;
+    std::condition_variable appends_resumed_;
+    MutationLogStats stats_;
+
+    // Удерживается на время записи в файл, чтобы замена файла не пересеклась со сбросом
+    std::mutex file_mutex_;
+    std::thread flusher_;
+
+    uint64_t Append(const std::string& record);
+    void FlushLoop();
+    static std::string MakeHeader();
+    // Пишет content во временный файл и переименованием делает его журналом; возвращает файл для дозаписи
+    std::FILE* CreateLogFile(const std::string& content) const;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mapped_vector.h"
+#include "posting_list.h"
+
+// Множество порядковых номеров документов: бит на номер
+class OrdinalBitmap {
+public:
+    OrdinalBitmap() = default;
+
+    // Карта в чужой памяти (например, в снимке индекса); первое изменение копирует её
+    OrdinalBitmap(const uint64_t* words, size_t ordinal_count)
+        : words_(words, GetWordCount(ordinal_count)) {
+    }
+
+    static size_t GetWordCount(size_t ordinal_count) {
+        return (ordinal_count + 63) / 64;
+    }
+
+    void Resize(size_t ordinal_count) {
+        if (words_.size() != GetWordCount(ordinal_count)) {
+            words_.resize(GetWordCount(ordinal_count));
+        }
+    }
+
+    void Clear() {
+        words_.Assign({});
+    }
+
+    void Set(DocumentOrdinal ordinal) {
+        words_.Set(ordinal / 64, words_[ordinal / 64] | uint64_t(1) << (ordinal % 64));
+    }
+
+    void Reset(DocumentOrdinal ordinal) {
+        words_.Set(ordinal / 64, words_[ordinal / 64] & ~(uint64_t(1) << (ordinal % 64)));
+    }
+
+    bool Test(DocumentOrdinal ordinal) const {
+        return (words_[ordinal / 64] >> (ordinal % 64)) & 1;
+    }
+
+    // Копирует карту из чужой памяти в собственный буфер
+    void Detach() {
+        words_.Detach();
+    }
+
+    const uint64_t* GetWords() const {
+        return words_.data();
+    }
+
+private:
+    MappedVector<uint64_t> words_;
+};
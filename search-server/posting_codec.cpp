@@ -0,0 +1,151 @@
+#include "posting_codec.h"
+
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace posting_codec {
+
+namespace {
+
+uint32_t LoadValue(const uint8_t* in, uint8_t width) {
+    switch (width) {
+    case 1:
+        return in[0];
+    case 2:
+        return in[0] | (in[1] << 8);
+    default:
+        return in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<uint32_t>(in[3]) << 24);
+    }
+}
+
+#if defined(__AVX2__)
+
+__m256i Load8(const uint8_t* in, uint8_t width) {
+    switch (width) {
+    case 1:
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)));
+    case 2:
+        return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)));
+    default:
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+    }
+}
+
+// Префиксная сумма по 8 лентам: сначала внутри 128-битных половин, затем перенос в старшую
+__m256i PrefixSum8(__m256i x) {
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    const __m256i low_total = _mm256_shuffle_epi32(x, 0xFF);
+    return _mm256_add_epi32(x, _mm256_permute2x128_si256(low_total, low_total, 0x08));
+}
+
+#elif defined(__SSE2__)
+
+__m128i Load4(const uint8_t* in, uint8_t width) {
+    const __m128i zero = _mm_setzero_si128();
+    switch (width) {
+    case 1: {
+        int32_t bytes;
+        memcpy(&bytes, in, sizeof(bytes));
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+    }
+    case 2:
+        return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)), zero);
+    default:
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    }
+}
+
+__m128i PrefixSum4(__m128i x) {
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    return _mm_add_epi32(x, _mm_slli_si128(x, 8));
+}
+
+#endif
+
+}  // namespace
+
+uint8_t ChooseWidth(uint32_t max_value) {
+    if (max_value <= 0xFF) {
+        return 1;
+    }
+    if (max_value <= 0xFFFF) {
+        return 2;
+    }
+    return 4;
+}
+
+void EncodeValues(const uint32_t* values, size_t count, uint8_t width, uint8_t* out) {
+    for (size_t i = 0; i < count; ++i) {
+        for (uint8_t byte = 0; byte < width; ++byte) {
+            *out++ = static_cast<uint8_t>(values[i] >> (8 * byte));
+        }
+    }
+}
+
+void DecodeValuesScalar(const uint8_t* in, size_t count, uint8_t width, uint32_t* out) {
+    for (size_t i = 0; i < count; ++i, in += width) {
+        out[i] = LoadValue(in, width);
+    }
+}
+
+void DecodeDeltasScalar(const uint8_t* in, size_t count, uint8_t width, uint32_t base, uint32_t* out) {
+    for (size_t i = 0; i < count; ++i, in += width) {
+        base += LoadValue(in, width);
+        out[i] = base;
+    }
+}
+
+void DecodeValues(const uint8_t* in, size_t count, uint8_t width, uint32_t* out) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8, in += 8 * width) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), Load8(in, width));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4, in += 4 * width) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), Load4(in, width));
+    }
+#endif
+    DecodeValuesScalar(in, count - i, width, out + i);
+}
+
+void DecodeDeltas(const uint8_t* in, size_t count, uint8_t width, uint32_t base, uint32_t* out) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i carry = _mm256_set1_epi32(static_cast<int>(base));
+    const __m256i last_lane = _mm256_set1_epi32(7);
+    for (; i + 8 <= count; i += 8, in += 8 * width) {
+        const __m256i sums = _mm256_add_epi32(PrefixSum8(Load8(in, width)), carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), sums);
+        carry = _mm256_permutevar8x32_epi32(sums, last_lane);
+    }
+    base = static_cast<uint32_t>(_mm256_cvtsi256_si32(carry));
+#elif defined(__SSE2__)
+    __m128i carry = _mm_set1_epi32(static_cast<int>(base));
+    for (; i + 4 <= count; i += 4, in += 4 * width) {
+        const __m128i sums = _mm_add_epi32(PrefixSum4(Load4(in, width)), carry);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), sums);
+        carry = _mm_shuffle_epi32(sums, 0xFF);
+    }
+    base = static_cast<uint32_t>(_mm_cvtsi128_si32(carry));
+#endif
+    DecodeDeltasScalar(in, count - i, width, base, out + i);
+}
+
+const char* GetDecoderName() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace posting_codec
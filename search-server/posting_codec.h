@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Кодирование блоков списков вхождений: значения хранятся байт-выровненными
+// полями ширины 1, 2 или 4 байта (минимальной, вмещающей максимум блока).
+// Номера документов кодируются разностями от первого номера блока.
+// Декодирование использует AVX2 или SSE2, если они доступны при компиляции,
+// иначе - скалярную реализацию.
+namespace posting_codec {
+
+uint8_t ChooseWidth(uint32_t max_value);
+
+void EncodeValues(const uint32_t* values, size_t count, uint8_t width, uint8_t* out);
+
+// out[i] = values[i]
+void DecodeValues(const uint8_t* in, size_t count, uint8_t width, uint32_t* out);
+// out[i] = base + values[0] + ... + values[i]
+void DecodeDeltas(const uint8_t* in, size_t count, uint8_t width, uint32_t base, uint32_t* out);
+
+void DecodeValuesScalar(const uint8_t* in, size_t count, uint8_t width, uint32_t* out);
+void DecodeDeltasScalar(const uint8_t* in, size_t count, uint8_t width, uint32_t base, uint32_t* out);
+
+// Название реализации, выбранной при компиляции: "avx2", "sse2" или "scalar"
+const char* GetDecoderName();
+
+}  // namespace posting_codec
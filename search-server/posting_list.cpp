@@ -0,0 +1,342 @@
+#include "posting_list.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+void PostingList::Append(DocumentOrdinal ordinal, uint32_t count) {
+    if (!Empty() && ordinal <= (tail_ordinals_.empty() ? blocks_.back().last_ordinal : tail_ordinals_.back())) {
+        throw invalid_argument("Posting ordinals must be appended in ascending order");
+    }
+    tail_ordinals_.push_back(ordinal);
+    tail_counts_.push_back(count);
+    ++size_;
+    if (tail_ordinals_.size() == kBlockSize) {
+        EncodeBlock(tail_ordinals_.data(), tail_counts_.data(), kBlockSize);
+        tail_ordinals_.clear();
+        tail_counts_.clear();
+    }
+}
+
+size_t PostingList::EraseAll(const vector<DocumentOrdinal>& sorted_ordinals) {
+    if (sorted_ordinals.empty() || Empty()) {
+        return 0;
+    }
+    const auto is_removed = [&sorted_ordinals](DocumentOrdinal ordinal) {
+        return binary_search(sorted_ordinals.begin(), sorted_ordinals.end(), ordinal);
+    };
+
+    // Перекодируются только блоки, в диапазон которых попадают удаляемые номера; остальные
+    // блоки и их данные не трогаются
+    vector<size_t> touched_blocks;
+    for (const DocumentOrdinal ordinal : sorted_ordinals) {
+        const size_t index = partition_point(blocks_.begin(), blocks_.end(),
+                                             [ordinal](const Block& block) { return block.last_ordinal < ordinal; })
+                             - blocks_.begin();
+        if (index < blocks_.size() && blocks_[index].first_ordinal <= ordinal
+            && (touched_blocks.empty() || touched_blocks.back() != index)) {
+            touched_blocks.push_back(index);
+        }
+    }
+
+    DocumentOrdinal ordinals[2 * kBlockSize];
+    uint32_t counts[2 * kBlockSize];
+    size_t erased = 0;
+    // С конца, чтобы удаление блока не сдвигало номера ещё не обработанных
+    for (auto it = touched_blocks.rbegin(); it != touched_blocks.rend(); ++it) {
+        const size_t index = *it;
+        const Block block = blocks_[index];
+        const size_t size = PostingListView::DecodeBlock(block, data_.data(), ordinals, counts);
+        size_t kept = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (!is_removed(ordinals[i])) {
+                ordinals[kept] = ordinals[i];
+                counts[kept] = counts[i];
+                ++kept;
+            }
+        }
+        erased += size - kept;
+        unused_bytes_ += GetBlockBytes(block);
+        // Поредевший блок сливается со следующим, если вместе они помещаются в один блок
+        if (kept < kBlockSize / 4 && index + 1 < blocks_.size() && kept + blocks_[index + 1].size <= kBlockSize) {
+            const Block& next = blocks_[index + 1];
+            kept += PostingListView::DecodeBlock(next, data_.data(), ordinals + kept, counts + kept);
+            unused_bytes_ += GetBlockBytes(next);
+            blocks_.erase(blocks_.begin() + index + 1);
+        }
+        if (kept == 0) {
+            blocks_.erase(blocks_.begin() + index);
+            continue;
+        }
+        blocks_[index] = EncodeBlockAt(ordinals, counts, kept, block.offset, GetBlockBytes(block));
+        if (blocks_[index].offset == block.offset) {
+            unused_bytes_ -= GetBlockBytes(blocks_[index]);
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < tail_ordinals_.size(); ++i) {
+        if (!is_removed(tail_ordinals_[i])) {
+            tail_ordinals_[kept] = tail_ordinals_[i];
+            tail_counts_[kept] = tail_counts_[i];
+            ++kept;
+        }
+    }
+    erased += tail_ordinals_.size() - kept;
+    tail_ordinals_.resize(kept);
+    tail_counts_.resize(kept);
+    size_ -= erased;
+
+    // Данные переупаковываются, когда неиспользуемых байт становится больше половины:
+    // стоимость переупаковки делится между удалениями, освободившими эти байты
+    if (unused_bytes_ * 2 > data_.size()) {
+        PackData();
+    }
+    return erased;
+}
+
+void PostingList::Remap(const vector<DocumentOrdinal>& new_ordinals) {
+    vector<DocumentOrdinal> ordinals;
+    vector<uint32_t> counts;
+    ordinals.reserve(size_);
+    counts.reserve(size_);
+    ForEach(0, static_cast<DocumentOrdinal>(new_ordinals.size()), [&](DocumentOrdinal ordinal, uint32_t count) {
+        ordinals.push_back(new_ordinals[ordinal]);
+        counts.push_back(count);
+    });
+    Assign(ordinals, counts);
+}
+
+bool PostingListView::Contains(DocumentOrdinal ordinal) const {
+    const Block* const blocks_end = blocks_ + block_count_;
+    const Block* block = partition_point(blocks_, blocks_end,
+                                         [ordinal](const Block& block) { return block.last_ordinal < ordinal; });
+    if (block == blocks_end) {
+        return binary_search(tail_ordinals_, tail_ordinals_ + tail_size_, ordinal);
+    }
+    if (block->first_ordinal > ordinal) {
+        return false;
+    }
+    DocumentOrdinal ordinals[kPostingBlockSize];
+    uint32_t counts[kPostingBlockSize];
+    const size_t size = DecodeBlock(*block, data_, ordinals, counts);
+    return binary_search(ordinals, ordinals + size, ordinal);
+}
+
+size_t PostingListView::Size() const {
+    return size_;
+}
+
+bool PostingListView::Empty() const {
+    return size_ == 0;
+}
+
+DocumentOrdinal PostingListView::FirstOrdinal() const {
+    return block_count_ == 0 ? tail_ordinals_[0] : blocks_[0].first_ordinal;
+}
+
+const PostingListView::Block* PostingListView::GetBlocks() const {
+    return blocks_;
+}
+
+size_t PostingListView::GetBlockCount() const {
+    return block_count_;
+}
+
+const uint8_t* PostingListView::GetData() const {
+    return data_;
+}
+
+size_t PostingListView::GetDataSize() const {
+    // После удалений блок может лежать дальше следующих, поэтому берётся наибольший конец
+    size_t data_size = 0;
+    for (size_t index = 0; index < block_count_; ++index) {
+        const Block& block = blocks_[index];
+        data_size = max<size_t>(data_size, block.offset + block.size * (block.delta_width + block.count_width));
+    }
+    return data_size;
+}
+
+const DocumentOrdinal* PostingListView::GetTailOrdinals() const {
+    return tail_ordinals_;
+}
+
+const uint32_t* PostingListView::GetTailCounts() const {
+    return tail_counts_;
+}
+
+size_t PostingListView::GetTailSize() const {
+    return tail_size_;
+}
+
+PostingCursor::PostingCursor(const PostingListView& postings)
+    : postings_(postings) {
+    LoadSegment(0);
+    Land();
+}
+
+DocumentOrdinal PostingCursor::GetOrdinal() const {
+    return ordinal_;
+}
+
+uint32_t PostingCursor::GetCount() const {
+    return segment_ < postings_.GetBlockCount() ? counts_[position_] : postings_.GetTailCounts()[position_];
+}
+
+void PostingCursor::Next() {
+    if (ordinal_ == kEnd) {
+        return;
+    }
+    if (++position_ == size_ && segment_ < postings_.GetBlockCount()) {
+        LoadSegment(segment_ + 1);
+    }
+    Land();
+}
+
+void PostingCursor::Advance(DocumentOrdinal ordinal) {
+    if (ordinal_ >= ordinal) {
+        return;
+    }
+    const size_t block_count = postings_.GetBlockCount();
+    const PostingBlock* blocks = postings_.GetBlocks();
+    if (segment_ < block_count && blocks[segment_].last_ordinal < ordinal) {
+        const PostingBlock* block = partition_point(blocks + segment_ + 1, blocks + block_count,
+                                                    [ordinal](const PostingBlock& block) { return block.last_ordinal < ordinal; });
+        LoadSegment(block - blocks);
+    }
+    const DocumentOrdinal* ordinals = GetSegmentOrdinals();
+    position_ = lower_bound(ordinals + position_, ordinals + size_, ordinal) - ordinals;
+    Land();
+}
+
+size_t PostingCursor::GetVisitedCount() const {
+    return visited_count_;
+}
+
+const PostingListView& PostingCursor::GetPostings() const {
+    return postings_;
+}
+
+void PostingCursor::LoadSegment(size_t segment) {
+    segment_ = segment;
+    position_ = 0;
+    size_ = segment < postings_.GetBlockCount()
+            ? PostingListView::DecodeBlock(postings_.GetBlocks()[segment], postings_.GetData(), ordinals_, counts_)
+            : postings_.GetTailSize();
+}
+
+const DocumentOrdinal* PostingCursor::GetSegmentOrdinals() const {
+    return segment_ < postings_.GetBlockCount() ? ordinals_ : postings_.GetTailOrdinals();
+}
+
+void PostingCursor::Land() {
+    if (position_ < size_) {
+        ordinal_ = GetSegmentOrdinals()[position_];
+        ++visited_count_;
+    } else {
+        ordinal_ = kEnd;
+    }
+}
+
+size_t PostingListView::DecodeBlock(const Block& block, const uint8_t* data, DocumentOrdinal* ordinals, uint32_t* counts) {
+    data += block.offset;
+    posting_codec::DecodeDeltas(data, block.size, block.delta_width, block.first_ordinal, ordinals);
+    posting_codec::DecodeValues(data + block.size * block.delta_width, block.size, block.count_width, counts);
+    return block.size;
+}
+
+PostingList::PostingList(const PostingListView& view)
+    : blocks_(view.GetBlocks(), view.GetBlocks() + view.GetBlockCount())
+    , data_(view.GetData(), view.GetData() + view.GetDataSize())
+    , tail_ordinals_(view.GetTailOrdinals(), view.GetTailOrdinals() + view.GetTailSize())
+    , tail_counts_(view.GetTailCounts(), view.GetTailCounts() + view.GetTailSize())
+    , size_(view.Size()) {
+    unused_bytes_ = data_.size();
+    for (const Block& block : blocks_) {
+        unused_bytes_ -= GetBlockBytes(block);
+    }
+}
+
+bool PostingList::Contains(DocumentOrdinal ordinal) const {
+    return View().Contains(ordinal);
+}
+
+size_t PostingList::Size() const {
+    return size_;
+}
+
+bool PostingList::Empty() const {
+    return size_ == 0;
+}
+
+DocumentOrdinal PostingList::FirstOrdinal() const {
+    return View().FirstOrdinal();
+}
+
+PostingListView PostingList::View() const {
+    return PostingListView(blocks_.data(), blocks_.size(), data_.data(),
+                           tail_ordinals_.data(), tail_counts_.data(), tail_ordinals_.size(), size_);
+}
+
+size_t PostingList::GetMemoryUsage() const {
+    return sizeof(*this) + blocks_.capacity() * sizeof(Block) + data_.capacity()
+           + tail_ordinals_.capacity() * sizeof(DocumentOrdinal) + tail_counts_.capacity() * sizeof(uint32_t);
+}
+
+void PostingList::EncodeBlock(const DocumentOrdinal* ordinals, const uint32_t* counts, size_t size) {
+    blocks_.push_back(EncodeBlockAt(ordinals, counts, size, data_.size(), 0));
+}
+
+PostingList::Block PostingList::EncodeBlockAt(const DocumentOrdinal* ordinals, const uint32_t* counts, size_t size,
+                                              size_t offset, size_t available_bytes) {
+    uint32_t deltas[kBlockSize];
+    deltas[0] = 0;
+    uint32_t max_delta = 0;
+    uint32_t max_count = counts[0];
+    for (size_t i = 1; i < size; ++i) {
+        deltas[i] = ordinals[i] - ordinals[i - 1];
+        max_delta = max(max_delta, deltas[i]);
+        max_count = max(max_count, counts[i]);
+    }
+    Block block{ordinals[0], ordinals[size - 1], static_cast<uint32_t>(offset), static_cast<uint16_t>(size),
+                posting_codec::ChooseWidth(max_delta), posting_codec::ChooseWidth(max_count)};
+    // Разности после удаления записей могут потребовать более широких полей, и тогда
+    // блок не помещается на прежнее место
+    if (GetBlockBytes(block) > available_bytes) {
+        block.offset = data_.size();
+        data_.resize(data_.size() + GetBlockBytes(block));
+    }
+    uint8_t* out = data_.data() + block.offset;
+    posting_codec::EncodeValues(deltas, size, block.delta_width, out);
+    posting_codec::EncodeValues(counts, size, block.count_width, out + size * block.delta_width);
+    return block;
+}
+
+size_t PostingList::GetBlockBytes(const Block& block) {
+    return block.size * (block.delta_width + block.count_width);
+}
+
+void PostingList::PackData() {
+    vector<uint8_t> data;
+    data.reserve(data_.size() - unused_bytes_);
+    for (Block& block : blocks_) {
+        const auto begin = data_.begin() + block.offset;
+        block.offset = data.size();
+        data.insert(data.end(), begin, begin + GetBlockBytes(block));
+    }
+    data_ = move(data);
+    unused_bytes_ = 0;
+}
+
+void PostingList::Assign(const vector<DocumentOrdinal>& ordinals, const vector<uint32_t>& counts) {
+    blocks_.clear();
+    data_.clear();
+    tail_ordinals_.clear();
+    tail_counts_.clear();
+    size_ = 0;
+    unused_bytes_ = 0;
+    for (size_t i = 0; i < ordinals.size(); ++i) {
+        Append(ordinals[i], counts[i]);
+    }
+    data_.shrink_to_fit();
+}
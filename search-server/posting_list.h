@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "posting_codec.h"
+
+// Внутренний плотный номер документа в индексе (в порядке добавления)
+using DocumentOrdinal = uint32_t;
+
+const size_t kPostingBlockSize = 128;
+
+// Заголовок сжатого блока; раскладка фиксирована, так как блоки пишутся в снимок индекса как есть
+struct PostingBlock {
+    DocumentOrdinal first_ordinal;
+    DocumentOrdinal last_ordinal;
+    uint32_t offset;
+    uint16_t size;
+    uint8_t delta_width;
+    uint8_t count_width;
+};
+
+static_assert(sizeof(PostingBlock) == 16, "PostingBlock is stored in index snapshots");
+
+// Статистика списка вхождений терма, которую индекс поддерживает при изменениях:
+// логарифм числа документов со словом и наибольшая частота слова в одном документе
+struct TermBounds {
+    double log_document_freq = 0;
+    double max_term_freq = 0;
+};
+
+static_assert(sizeof(TermBounds) == 16, "TermBounds is stored in index snapshots");
+
+// Неизменяемое представление списка вхождений поверх чужой памяти:
+// буферов PostingList или отображённого в память снимка
+class PostingListView {
+public:
+    using Block = PostingBlock;
+
+    PostingListView() = default;
+    PostingListView(const Block* blocks, size_t block_count, const uint8_t* data,
+                    const DocumentOrdinal* tail_ordinals, const uint32_t* tail_counts, size_t tail_size, size_t size)
+        : blocks_(blocks)
+        , block_count_(block_count)
+        , data_(data)
+        , tail_ordinals_(tail_ordinals)
+        , tail_counts_(tail_counts)
+        , tail_size_(tail_size)
+        , size_(size) {}
+
+    bool Contains(DocumentOrdinal ordinal) const;
+    size_t Size() const;
+    bool Empty() const;
+    DocumentOrdinal FirstOrdinal() const;
+
+    // Вызывает function(ordinal, count) для записей с номерами из [first, last)
+    template <typename Function>
+    void ForEach(DocumentOrdinal first, DocumentOrdinal last, Function function) const;
+
+    const Block* GetBlocks() const;
+    size_t GetBlockCount() const;
+    const uint8_t* GetData() const;
+    // Размер буфера сжатых данных в байтах: от начала до конца самого дальнего блока
+    size_t GetDataSize() const;
+    const DocumentOrdinal* GetTailOrdinals() const;
+    const uint32_t* GetTailCounts() const;
+    size_t GetTailSize() const;
+
+    static size_t DecodeBlock(const Block& block, const uint8_t* data, DocumentOrdinal* ordinals, uint32_t* counts);
+
+private:
+    const Block* blocks_ = nullptr;
+    size_t block_count_ = 0;
+    const uint8_t* data_ = nullptr;
+    const DocumentOrdinal* tail_ordinals_ = nullptr;
+    const uint32_t* tail_counts_ = nullptr;
+    size_t tail_size_ = 0;
+    size_t size_ = 0;
+};
+
+// Курсор для обхода списка документ за документом, по возрастанию номеров. Блоки
+// распаковываются по одному, а Advance перескакивает блоки, целиком лежащие до
+// нужного номера, не распаковывая их
+class PostingCursor {
+public:
+    static const DocumentOrdinal kEnd = std::numeric_limits<DocumentOrdinal>::max();
+
+    PostingCursor() = default;
+    explicit PostingCursor(const PostingListView& postings);
+
+    // kEnd, если записи кончились
+    DocumentOrdinal GetOrdinal() const;
+    uint32_t GetCount() const;
+
+    void Next();
+    // Переходит к первой записи с номером не меньше ordinal
+    void Advance(DocumentOrdinal ordinal);
+
+    // Число записей, на которых курсор останавливался
+    size_t GetVisitedCount() const;
+    const PostingListView& GetPostings() const;
+
+private:
+    PostingListView postings_;
+    // Текущий сегмент: блок с этим номером или несжатый хвост, если номер равен числу блоков
+    size_t segment_ = 0;
+    size_t size_ = 0;
+    size_t position_ = 0;
+    DocumentOrdinal ordinal_ = kEnd;
+    size_t visited_count_ = 0;
+    DocumentOrdinal ordinals_[kPostingBlockSize];
+    uint32_t counts_[kPostingBlockSize];
+
+    void LoadSegment(size_t segment);
+    const DocumentOrdinal* GetSegmentOrdinals() const;
+    // Ставит курсор на запись position_ текущего сегмента
+    void Land();
+};
+
+// Сжатый список вхождений терма: порядковые номера документов по возрастанию
+// и число вхождений терма в каждый из них. Записи хранятся блоками до kBlockSize:
+// номера - разностями от начала блока, счётчики - рядом с ними, оба поля
+// байт-выровненной минимальной ширины (см. posting_codec.h).
+// Последние записи, ещё не набравшие полный блок, хранятся несжатыми.
+class PostingList {
+public:
+    static const size_t kBlockSize = kPostingBlockSize;
+    using Block = PostingBlock;
+
+    PostingList() = default;
+    // Копия списка из представления (например, при переходе от снимка к изменяемому индексу)
+    explicit PostingList(const PostingListView& view);
+
+    // Номера должны добавляться по возрастанию
+    void Append(DocumentOrdinal ordinal, uint32_t count);
+    size_t EraseAll(const std::vector<DocumentOrdinal>& sorted_ordinals);
+    // Перенумерация после уплотнения индекса; new_ordinals монотонна на живых документах
+    void Remap(const std::vector<DocumentOrdinal>& new_ordinals);
+
+    bool Contains(DocumentOrdinal ordinal) const;
+    size_t Size() const;
+    bool Empty() const;
+    DocumentOrdinal FirstOrdinal() const;
+
+    // Вызывает function(ordinal, count) для записей с номерами из [first, last)
+    template <typename Function>
+    void ForEach(DocumentOrdinal first, DocumentOrdinal last, Function function) const;
+
+    PostingListView View() const;
+
+    // Занимаемая списком память в байтах
+    size_t GetMemoryUsage() const;
+
+private:
+    std::vector<Block> blocks_;
+    std::vector<uint8_t> data_;
+    std::vector<DocumentOrdinal> tail_ordinals_;
+    std::vector<uint32_t> tail_counts_;
+    size_t size_ = 0;
+    // Байты data_, не занятые ни одним блоком: остались от блоков, перекодированных при удалении
+    size_t unused_bytes_ = 0;
+
+    void EncodeBlock(const DocumentOrdinal* ordinals, const uint32_t* counts, size_t size);
+    // Кодирует блок на место offset, если он занимает не больше available_bytes, иначе в конец data_
+    Block EncodeBlockAt(const DocumentOrdinal* ordinals, const uint32_t* counts, size_t size,
+                        size_t offset, size_t available_bytes);
+    static size_t GetBlockBytes(const Block& block);
+    // Сдвигает данные блоков вплотную, освобождая неиспользуемые байты
+    void PackData();
+    void Assign(const std::vector<DocumentOrdinal>& ordinals, const std::vector<uint32_t>& counts);
+};
+
+template <typename Function>
+void PostingListView::ForEach(DocumentOrdinal first, DocumentOrdinal last, Function function) const {
+    DocumentOrdinal ordinals[kPostingBlockSize];
+    uint32_t counts[kPostingBlockSize];
+    const Block* const blocks_end = blocks_ + block_count_;
+    const Block* block = first == 0 ? blocks_
+                                    : std::partition_point(blocks_, blocks_end,
+                                                           [first](const Block& block) { return block.last_ordinal < first; });
+    for (; block != blocks_end && block->first_ordinal < last; ++block) {
+        const size_t size = DecodeBlock(*block, data_, ordinals, counts);
+        if (first <= block->first_ordinal && block->last_ordinal < last) {
+            for (size_t i = 0; i < size; ++i) {
+                function(ordinals[i], counts[i]);
+            }
+        } else {
+            for (size_t i = 0; i < size; ++i) {
+                if (first <= ordinals[i] && ordinals[i] < last) {
+                    function(ordinals[i], counts[i]);
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < tail_size_; ++i) {
+        if (first <= tail_ordinals_[i] && tail_ordinals_[i] < last) {
+            function(tail_ordinals_[i], tail_counts_[i]);
+        }
+    }
+}
+
+template <typename Function>
+void PostingList::ForEach(DocumentOrdinal first, DocumentOrdinal last, Function function) const {
+    View().ForEach(first, last, function);
+}
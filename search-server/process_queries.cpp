@@ -1,4 +1,3 @@
-#include <execution>
 #include <algorithm>
 
 #include "process_queries.h"
@@ -9,11 +8,24 @@ vector<vector<Document>> ProcessQueries(
         const SearchServer& search_server,
         const vector<string>& queries){
 
+    return ProcessQueries(search_server, queries, QueryExecutor::GetCurrent());
+}
+
+vector<vector<Document>> ProcessQueries(
+        const SearchServer& search_server,
+        const vector<string>& queries,
+        QueryExecutor& executor,
+        size_t grain_size,
+        BatchStats* stats){
+
     vector<vector<Document>> temp(queries.size());
-    transform(execution::par, queries.begin(), queries.end(), temp.begin(),
-                   [&search_server](const string& word){
-                        return move(search_server.FindTopDocuments(word));
+    const BatchStats batch_stats = executor.ParallelFor(queries.size(), grain_size,
+                   [&search_server, &queries, &temp](size_t index){
+                        temp[index] = search_server.FindTopDocuments(queries[index]);
                     });
+    if (stats != nullptr) {
+        *stats = batch_stats;
+    }
     return temp;
 }
 
@@ -21,12 +33,9 @@ vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const vector<string>& queries){
 
-    return transform_reduce(execution::par, queries.begin(), queries.end(), vector<Document>{},
-                                [](vector<Document> lhs, vector<Document> const& rhs){
-                                    lhs.insert(lhs.end(), rhs.begin(), rhs.end());
-                                    return lhs;
-                                },
-                                [&search_server](const string& query){
-                                    return search_server.FindTopDocuments(query);
-                                });
+    vector<Document> joined;
+    for (const vector<Document>& documents : ProcessQueries(search_server, queries)) {
+        joined.insert(joined.end(), documents.begin(), documents.end());
+    }
+    return joined;
 }
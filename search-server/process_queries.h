@@ -1,4 +1,5 @@
 #pragma once
+#include "query_executor.h"
 #include "search_server.h"
 #include <vector>
 #include <string>
@@ -7,6 +8,16 @@ std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
+// Запросы выполняются задачами исполнителя (без него - текущего); grain_size - сколько запросов подряд
+// может выполнить одна задача (0 - подобрать по числу потоков), дешёвые запросы
+// выгоднее группировать крупнее. stats, если задан, получает счётчики пачки
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    QueryExecutor& executor,
+    size_t grain_size = 0,
+    BatchStats* stats = nullptr);
+
 std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
@@ -0,0 +1,74 @@
+#include "query_cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+using namespace std;
+
+double QueryCacheStats::GetHitRate() const {
+    const uint64_t lookups = hits + misses;
+    return lookups > 0 ? hits * 1.0 / lookups : 0.0;
+}
+
+QueryCache::QueryCache(QueryCacheOptions options) {
+    if (options.capacity == 0 || options.shard_count == 0) {
+        throw invalid_argument("Query cache capacity and shard count must be positive");
+    }
+    const size_t shard_count = min(options.shard_count, options.capacity);
+    shard_capacity_ = (options.capacity + shard_count - 1) / shard_count;
+    for (size_t index = 0; index < shard_count; ++index) {
+        shards_.push_back(make_unique<Shard>());
+    }
+}
+
+bool QueryCache::Find(const string& key, uint64_t generation, vector<Document>& documents) {
+    Shard& shard = GetShard(key);
+    lock_guard lock(shard.mutex);
+    const auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses_.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    if (it->second->generation != generation) {
+        shard.entries.erase(it->second);
+        shard.index.erase(it);
+        invalidations_.fetch_add(1, memory_order_relaxed);
+        misses_.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    documents = it->second->documents;
+    hits_.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void QueryCache::Insert(const string& key, uint64_t generation, const vector<Document>& documents) {
+    Shard& shard = GetShard(key);
+    lock_guard lock(shard.mutex);
+    const auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        // Запрос успели посчитать параллельно; остаётся более свежее поколение
+        if (it->second->generation < generation) {
+            it->second->generation = generation;
+            it->second->documents = documents;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+    if (shard.entries.size() >= shard_capacity_) {
+        shard.index.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+        evictions_.fetch_add(1, memory_order_relaxed);
+    }
+    shard.entries.push_front({ key, generation, documents });
+    shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+}
+
+QueryCacheStats QueryCache::GetStats() const {
+    return { hits_.load(), misses_.load(), evictions_.load(), invalidations_.load() };
+}
+
+QueryCache::Shard& QueryCache::GetShard(const string& key) {
+    return *shards_[hash<string>{}(key) % shards_.size()];
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+struct QueryCacheOptions {
+    // Общее число запоминаемых запросов, делится поровну между сегментами
+    size_t capacity = 4096;
+    // Сегменты с отдельными блокировками, чтобы параллельные запросы не ждали друг друга
+    size_t shard_count = 16;
+};
+
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Вытеснены по LRU и отброшены из-за изменения индекса
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;
+
+    double GetHitRate() const;
+};
+
+// Кэш результатов поиска: ключ - нормализованный запрос (упорядоченные плюс- и минус-слова
+// без стоп-слов) вместе с фильтром документов, значение - готовый top-K. Каждая запись помнит
+// поколение индекса, для которого посчитана; запись другого поколения считается промахом
+class QueryCache {
+public:
+    explicit QueryCache(QueryCacheOptions options = {});
+
+    template <typename WordContainer>
+    static std::string MakeKey(const WordContainer& plus_words, const WordContainer& minus_words,
+                               const DocumentFilter& filter, size_t max_result_count);
+
+    bool Find(const std::string& key, uint64_t generation, std::vector<Document>& documents);
+    void Insert(const std::string& key, uint64_t generation, const std::vector<Document>& documents);
+
+    QueryCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        std::vector<Document> documents;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        // Начало списка - последние использованные записи
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    };
+
+    size_t shard_capacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> invalidations_{0};
+
+    Shard& GetShard(const std::string& key);
+};
+
+template <typename WordContainer>
+std::string QueryCache::MakeKey(const WordContainer& plus_words, const WordContainer& minus_words,
+                                const DocumentFilter& filter, size_t max_result_count) {
+    // Слова не содержат управляющих символов, поэтому они служат разделителями
+    std::string key;
+    for (std::string_view word : plus_words) {
+        key.append(word);
+        key.push_back('\x01');
+    }
+    key.push_back('\x02');
+    for (std::string_view word : minus_words) {
+        key.append(word);
+        key.push_back('\x01');
+    }
+    key.push_back('\x02');
+    if (filter.status) {
+        key.append(std::to_string(static_cast<int>(*filter.status)));
+    }
+    key.push_back('\x01');
+    key.append(std::to_string(filter.min_rating));
+    key.push_back('\x01');
+    key.append(std::to_string(filter.max_rating));
+    key.push_back('\x02');
+    key.append(std::to_string(max_result_count));
+    return key;
+}
@@ -0,0 +1,249 @@
+#include "query_executor.h"
+
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// Исполнитель и очередь, задачи которых выполняет текущий поток
+thread_local QueryExecutor* current_executor = nullptr;
+thread_local size_t current_queue = 0;
+
+QueryExecutorOptions& GetDefaultOptions() {
+    static QueryExecutorOptions options;
+    return options;
+}
+
+atomic<bool> default_created{false};
+
+// На время ParallelFor текущий поток считается потоком исполнителя, чтобы вложенные вызовы шли в него же
+class CurrentExecutorScope {
+public:
+    CurrentExecutorScope(QueryExecutor* executor, size_t queue)
+        : outer_executor_(current_executor), outer_queue_(current_queue) {
+        current_executor = executor;
+        current_queue = queue;
+    }
+
+    ~CurrentExecutorScope() {
+        current_executor = outer_executor_;
+        current_queue = outer_queue_;
+    }
+
+private:
+    QueryExecutor* outer_executor_;
+    size_t outer_queue_;
+};
+
+void PinCurrentThread(int cpu) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+    (void)cpu;
+#endif
+}
+
+}  // namespace
+
+double BatchStats::GetItemsPerSecond() const {
+    return elapsed.count() > 0 ? items / chrono::duration<double>(elapsed).count() : 0.0;
+}
+
+QueryExecutor::QueryExecutor(QueryExecutorOptions options)
+    : thread_count_(options.thread_count) {
+    if (thread_count_ == 0) {
+        throw invalid_argument("Executor needs at least one thread");
+    }
+    for (size_t index = 0; index < thread_count_; ++index) {
+        queues_.push_back(make_unique<WorkQueue>());
+    }
+    for (size_t index = 0; index + 1 < thread_count_; ++index) {
+        const int cpu = options.cpu_affinity.empty() ? -1 : options.cpu_affinity[index % options.cpu_affinity.size()];
+        workers_.emplace_back([this, index, cpu] { WorkerLoop(index, cpu); });
+    }
+}
+
+QueryExecutor::~QueryExecutor() {
+    {
+        lock_guard lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t QueryExecutor::GetThreadCount() const {
+    return thread_count_;
+}
+
+ExecutorStats QueryExecutor::GetStats() const {
+    return { batches_.load(), items_.load(), tasks_.load(), steals_.load() };
+}
+
+QueryExecutor& QueryExecutor::GetDefault() {
+    static QueryExecutor executor((default_created = true, GetDefaultOptions()));
+    return executor;
+}
+
+void QueryExecutor::ConfigureDefault(QueryExecutorOptions options) {
+    if (default_created) {
+        throw logic_error("Default executor is already running");
+    }
+    GetDefaultOptions() = move(options);
+}
+
+QueryExecutor& QueryExecutor::GetCurrent() {
+    return current_executor != nullptr ? *current_executor : GetDefault();
+}
+
+BatchStats QueryExecutor::Run(size_t count, size_t grain_size, Invoke invoke, void* function) {
+    const auto start = chrono::steady_clock::now();
+    BatchStats stats;
+    stats.items = count;
+    if (grain_size == 0) {
+        grain_size = max<size_t>(1, count / (4 * thread_count_));
+    }
+
+    const size_t queue = GetOwnQueue();
+    const CurrentExecutorScope scope(this, queue);
+    if (workers_.empty() || count <= grain_size) {
+        // Делить не на кого или нечего: весь диапазон выполняется на месте
+        if (count > 0) {
+            invoke(function, 0, count);
+            stats.tasks = 1;
+        }
+    } else {
+        Job job;
+        job.invoke = invoke;
+        job.function = function;
+        job.grain_size = grain_size;
+        job.remaining.store(count, memory_order_relaxed);
+        Execute(queue, { &job, 0, count }, false);
+        while (job.remaining.load(memory_order_acquire) != 0) {
+            Range range;
+            if (Pop(queue, range)) {
+                Execute(queue, range, false);
+            } else if (Steal(queue, range)) {
+                Execute(queue, range, true);
+            } else {
+                this_thread::yield();
+            }
+        }
+        if (job.exception) {
+            rethrow_exception(job.exception);
+        }
+        stats.tasks = job.tasks.load();
+        stats.steals = job.steals.load();
+    }
+
+    stats.elapsed = chrono::steady_clock::now() - start;
+    batches_.fetch_add(1, memory_order_relaxed);
+    items_.fetch_add(stats.items, memory_order_relaxed);
+    tasks_.fetch_add(stats.tasks, memory_order_relaxed);
+    steals_.fetch_add(stats.steals, memory_order_relaxed);
+    return stats;
+}
+
+size_t QueryExecutor::GetOwnQueue() const {
+    return current_executor == this ? current_queue : queues_.size() - 1;
+}
+
+void QueryExecutor::Push(size_t queue, Range range) {
+    // Счётчик растёт до появления части в очереди, чтобы не уйти в минус при её немедленной краже
+    queued_.fetch_add(1);
+    {
+        lock_guard lock(queues_[queue]->mutex);
+        queues_[queue]->ranges.push_back(range);
+    }
+    if (sleeping_.load() > 0) {
+        lock_guard lock(sleep_mutex_);
+        wake_.notify_one();
+    }
+}
+
+bool QueryExecutor::Pop(size_t queue, Range& range) {
+    lock_guard lock(queues_[queue]->mutex);
+    auto& ranges = queues_[queue]->ranges;
+    if (ranges.empty()) {
+        return false;
+    }
+    range = ranges.back();
+    ranges.pop_back();
+    queued_.fetch_sub(1);
+    return true;
+}
+
+bool QueryExecutor::Steal(size_t thief, Range& range) {
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        WorkQueue& victim = *queues_[(thief + offset) % queues_.size()];
+        lock_guard lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void QueryExecutor::Execute(size_t queue, Range range, bool stolen) {
+    Job& job = *range.job;
+    // Вторая половина уходит в очередь, где её может забрать простаивающий поток
+    while (range.last - range.first > job.grain_size) {
+        const size_t middle = range.first + (range.last - range.first) / 2;
+        Push(queue, { &job, middle, range.last });
+        range.last = middle;
+    }
+    if (!job.failed.load(memory_order_relaxed)) {
+        try {
+            job.invoke(job.function, range.first, range.last);
+        } catch (...) {
+            if (!job.failed.exchange(true)) {
+                job.exception = current_exception();
+            }
+        }
+    }
+    job.tasks.fetch_add(1, memory_order_relaxed);
+    if (stolen) {
+        job.steals.fetch_add(1, memory_order_relaxed);
+    }
+    job.remaining.fetch_sub(range.last - range.first, memory_order_acq_rel);
+}
+
+void QueryExecutor::WorkerLoop(size_t index, int cpu) {
+    if (cpu >= 0) {
+        PinCurrentThread(cpu);
+    }
+    current_executor = this;
+    current_queue = index;
+    while (true) {
+        Range range;
+        if (Pop(index, range)) {
+            Execute(index, range, false);
+            continue;
+        }
+        if (Steal(index, range)) {
+            Execute(index, range, true);
+            continue;
+        }
+        unique_lock lock(sleep_mutex_);
+        sleeping_.fetch_add(1);
+        wake_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+        sleeping_.fetch_sub(1);
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct QueryExecutorOptions {
+    // Число потоков, выполняющих задачи, включая поток, вызвавший ParallelFor
+    size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+    // Процессоры для закрепления рабочих потоков: поток i - на cpu_affinity[i % size()].
+    // Пусто - без закрепления; на системах без pthread_setaffinity_np игнорируется
+    std::vector<int> cpu_affinity;
+};
+
+// Счётчики одного вызова ParallelFor
+struct BatchStats {
+    size_t items = 0;
+    // Выполненные части диапазона и те из них, что забраны из чужих очередей
+    size_t tasks = 0;
+    size_t steals = 0;
+    std::chrono::nanoseconds elapsed{0};
+
+    double GetItemsPerSecond() const;
+};
+
+// Суммарные счётчики исполнителя
+struct ExecutorStats {
+    uint64_t batches = 0;
+    uint64_t items = 0;
+    uint64_t tasks = 0;
+    uint64_t steals = 0;
+};
+
+// Пул потоков с перехватом работы (work stealing) для обработки запросов.
+// У каждого рабочего потока своя очередь частей диапазона: владелец берёт части
+// с конца (самые мелкие и свежие), простаивающие потоки забирают с начала (самые
+// крупные). Поток, ждущий завершения ParallelFor, сам выполняет задачи, поэтому
+// вложенный ParallelFor из задачи не создаёт потоков сверх thread_count.
+class QueryExecutor {
+public:
+    explicit QueryExecutor(QueryExecutorOptions options = {});
+    QueryExecutor(const QueryExecutor&) = delete;
+    QueryExecutor& operator=(const QueryExecutor&) = delete;
+    ~QueryExecutor();
+
+    size_t GetThreadCount() const;
+
+    // Вызывает function(index) для каждого index из [0, count). Диапазон делится пополам,
+    // пока части длиннее grain_size (0 - подобрать по числу потоков). Первое исключение
+    // из function пробрасывается после завершения уже начатых частей
+    template <typename Function>
+    BatchStats ParallelFor(size_t count, size_t grain_size, Function function);
+
+    ExecutorStats GetStats() const;
+
+    // Общий исполнитель; создаётся при первом обращении
+    static QueryExecutor& GetDefault();
+    // Задаёт параметры общего исполнителя; вызывать до его первого использования
+    static void ConfigureDefault(QueryExecutorOptions options);
+    // Исполнитель, задачу которого выполняет текущий поток, иначе общий
+    static QueryExecutor& GetCurrent();
+
+private:
+    using Invoke = void (*)(void* function, size_t first, size_t last);
+
+    struct Job {
+        Invoke invoke = nullptr;
+        void* function = nullptr;
+        size_t grain_size = 0;
+        std::atomic<size_t> remaining{0};
+        std::atomic<size_t> tasks{0};
+        std::atomic<size_t> steals{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr exception;
+    };
+
+    struct Range {
+        Job* job;
+        size_t first;
+        size_t last;
+    };
+
+    struct alignas(64) WorkQueue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    size_t thread_count_;
+    // Очереди рабочих потоков; последняя - общая для внешних потоков, вызвавших ParallelFor
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> sleeping_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> items_{0};
+    std::atomic<uint64_t> tasks_{0};
+    std::atomic<uint64_t> steals_{0};
+
+    BatchStats Run(size_t count, size_t grain_size, Invoke invoke, void* function);
+    size_t GetOwnQueue() const;
+    void Push(size_t queue, Range range);
+    bool Pop(size_t queue, Range& range);
+    bool Steal(size_t thief, Range& range);
+    void Execute(size_t queue, Range range, bool stolen);
+    void WorkerLoop(size_t index, int cpu);
+};
+
+template <typename Function>
+BatchStats QueryExecutor::ParallelFor(size_t count, size_t grain_size, Function function) {
+    return Run(count, grain_size, [](void* function, size_t first, size_t last) {
+        Function& typed_function = *static_cast<Function*>(function);
+        for (size_t index = first; index < last; ++index) {
+            typed_function(index);
+        }
+    }, &function);
+}
@@ -0,0 +1,137 @@
+#include "query_trace.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Счётчики одного потока: пишет только сам поток, поэтому прибавление - это чтение и запись,
+// а не атомарная операция над общей строкой кэша
+struct ThreadTrace {
+    array<atomic<uint64_t>, kQueryStageCount> calls{};
+    array<atomic<uint64_t>, kQueryStageCount> nanoseconds{};
+    atomic<uint64_t> queries{0};
+    atomic<uint64_t> postings{0};
+    atomic<uint64_t> skipped_postings{0};
+    atomic<uint64_t> candidates{0};
+    atomic<uint64_t> matched_documents{0};
+};
+
+void Add(atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+// Счётчики завершившихся потоков остаются в реестре; Reset запоминает текущие суммы,
+// а не обнуляет счётчики, чтобы не писать в чужие потоки
+struct TraceRegistry {
+    mutex traces_mutex;
+    vector<shared_ptr<ThreadTrace>> traces;
+    QueryTraceStats baseline;
+};
+
+TraceRegistry& GetRegistry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+ThreadTrace& GetThreadTrace() {
+    static thread_local shared_ptr<ThreadTrace> trace = [] {
+        auto trace = make_shared<ThreadTrace>();
+        TraceRegistry& registry = GetRegistry();
+        lock_guard lock(registry.traces_mutex);
+        registry.traces.push_back(trace);
+        return trace;
+    }();
+    return *trace;
+}
+
+QueryTraceStats SumTraces(const TraceRegistry& registry) {
+    QueryTraceStats stats;
+    for (const auto& trace : registry.traces) {
+        for (size_t stage = 0; stage < kQueryStageCount; ++stage) {
+            stats.stages[stage].calls += trace->calls[stage].load(memory_order_relaxed);
+            stats.stages[stage].elapsed += chrono::nanoseconds(trace->nanoseconds[stage].load(memory_order_relaxed));
+        }
+        stats.queries += trace->queries.load(memory_order_relaxed);
+        stats.postings += trace->postings.load(memory_order_relaxed);
+        stats.skipped_postings += trace->skipped_postings.load(memory_order_relaxed);
+        stats.candidates += trace->candidates.load(memory_order_relaxed);
+        stats.matched_documents += trace->matched_documents.load(memory_order_relaxed);
+    }
+    return stats;
+}
+
+}  // namespace
+
+string_view GetQueryStageName(QueryStage stage) {
+    switch (stage) {
+        case QueryStage::PARSE:
+            return "parse";
+        case QueryStage::POSTINGS:
+            return "postings";
+        case QueryStage::MINUS_WORDS:
+            return "minus_words";
+        case QueryStage::COLLECT:
+            return "collect";
+        case QueryStage::TOP_K:
+            return "top_k";
+    }
+    return "unknown";
+}
+
+const QueryStageStats& QueryTraceStats::GetStage(QueryStage stage) const {
+    return stages[static_cast<size_t>(stage)];
+}
+
+double QueryTraceStats::GetSkippedShare() const {
+    const uint64_t total_postings = postings + skipped_postings;
+    return total_postings > 0 ? skipped_postings * 1.0 / total_postings : 0.0;
+}
+
+void QueryTrace::SetEnabled(bool is_enabled) {
+    is_enabled_.store(is_enabled, memory_order_relaxed);
+}
+
+QueryTraceStats QueryTrace::GetStats() {
+    TraceRegistry& registry = GetRegistry();
+    lock_guard lock(registry.traces_mutex);
+    QueryTraceStats stats = SumTraces(registry);
+    for (size_t stage = 0; stage < kQueryStageCount; ++stage) {
+        stats.stages[stage].calls -= registry.baseline.stages[stage].calls;
+        stats.stages[stage].elapsed -= registry.baseline.stages[stage].elapsed;
+    }
+    stats.queries -= registry.baseline.queries;
+    stats.postings -= registry.baseline.postings;
+    stats.skipped_postings -= registry.baseline.skipped_postings;
+    stats.candidates -= registry.baseline.candidates;
+    stats.matched_documents -= registry.baseline.matched_documents;
+    return stats;
+}
+
+void QueryTrace::Reset() {
+    TraceRegistry& registry = GetRegistry();
+    lock_guard lock(registry.traces_mutex);
+    registry.baseline = SumTraces(registry);
+}
+
+void QueryTrace::AddStage(QueryStage stage, chrono::nanoseconds elapsed) {
+    ThreadTrace& trace = GetThreadTrace();
+    Add(trace.calls[static_cast<size_t>(stage)], 1);
+    Add(trace.nanoseconds[static_cast<size_t>(stage)], elapsed.count());
+}
+
+void QueryTrace::AddQuery(uint64_t postings, uint64_t skipped_postings) {
+    ThreadTrace& trace = GetThreadTrace();
+    Add(trace.queries, 1);
+    Add(trace.postings, postings);
+    Add(trace.skipped_postings, skipped_postings);
+}
+
+void QueryTrace::AddDocuments(uint64_t candidates, uint64_t matched_documents) {
+    ThreadTrace& trace = GetThreadTrace();
+    Add(trace.candidates, candidates);
+    Add(trace.matched_documents, matched_documents);
+}
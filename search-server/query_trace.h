@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Трассировка исключается при компиляции с -DSEARCH_SERVER_NO_TRACING: все проверки
+// превращаются в константу false, и таймеры стадий не оставляют в коде ничего
+#ifdef SEARCH_SERVER_NO_TRACING
+inline constexpr bool kQueryTracingCompiled = false;
+#else
+inline constexpr bool kQueryTracingCompiled = true;
+#endif
+
+// Стадии выполнения запроса
+enum class QueryStage {
+    // Разбор текста запроса
+    PARSE,
+    // Обход списков вхождений плюс-слов с накоплением релевантности (у WAND - весь обход)
+    POSTINGS,
+    // Пометка документов минус-слов до обхода плюс-слов
+    MINUS_WORDS,
+    // Сбор набранных документов с проверкой предиката
+    COLLECT,
+    // Отбор и сортировка лучших документов
+    TOP_K,
+};
+
+const size_t kQueryStageCount = 5;
+
+std::string_view GetQueryStageName(QueryStage stage);
+
+struct QueryStageStats {
+    uint64_t calls = 0;
+    // Сумма по всем потокам: у параллельных запросов больше времени выполнения запроса
+    std::chrono::nanoseconds elapsed{0};
+};
+
+struct QueryTraceStats {
+    std::array<QueryStageStats, kQueryStageCount> stages;
+    uint64_t queries = 0;
+    // Пройденные вхождения плюс-слов и пропущенные отсечением WAND
+    uint64_t postings = 0;
+    uint64_t skipped_postings = 0;
+    // Документы, дошедшие до проверки предиката, и прошедшие её
+    uint64_t candidates = 0;
+    uint64_t matched_documents = 0;
+
+    const QueryStageStats& GetStage(QueryStage stage) const;
+    // Доля вхождений плюс-слов, пропущенных отсечением
+    double GetSkippedShare() const;
+};
+
+// Счётчики стадий запросов всего процесса. Каждый поток пишет в свои счётчики без
+// синхронизации с другими, GetStats суммирует их по запросу. По умолчанию выключена
+class QueryTrace {
+public:
+    static void SetEnabled(bool is_enabled);
+
+    static bool IsEnabled() {
+        return kQueryTracingCompiled && is_enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Счётчики с момента последнего Reset
+    static QueryTraceStats GetStats();
+    static void Reset();
+
+    static void CountQuery(uint64_t postings, uint64_t skipped_postings = 0) {
+        if (IsEnabled()) {
+            AddQuery(postings, skipped_postings);
+        }
+    }
+
+    static void CountDocuments(uint64_t candidates, uint64_t matched_documents) {
+        if (IsEnabled()) {
+            AddDocuments(candidates, matched_documents);
+        }
+    }
+
+    static void AddStage(QueryStage stage, std::chrono::nanoseconds elapsed);
+
+private:
+    static inline std::atomic<bool> is_enabled_{false};
+
+    static void AddQuery(uint64_t postings, uint64_t skipped_postings);
+    static void AddDocuments(uint64_t candidates, uint64_t matched_documents);
+};
+
+// Замеряет время стадии от создания до разрушения, если трассировка включена
+class QueryStageTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit QueryStageTimer(QueryStage stage)
+        : stage_(stage)
+        , is_active_(QueryTrace::IsEnabled()) {
+        if (is_active_) {
+            start_ = Clock::now();
+        }
+    }
+
+    QueryStageTimer(const QueryStageTimer&) = delete;
+    QueryStageTimer& operator=(const QueryStageTimer&) = delete;
+
+    ~QueryStageTimer() {
+        Stop();
+    }
+
+    // Завершает стадию раньше конца области видимости
+    void Stop() {
+        if (is_active_) {
+            QueryTrace::AddStage(stage_, Clock::now() - start_);
+            is_active_ = false;
+        }
+    }
+
+private:
+    QueryStage stage_;
+    bool is_active_;
+    Clock::time_point start_;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "posting_list.h"
+
+// Плотный аккумулятор релевантности по порядковым номерам документов.
+// Сброс между запросами не требует обнуления массивов: каждая ячейка помечена
+// номером запроса (stamp), действительны только ячейки с текущей меткой.
+class RelevanceAccumulator {
+public:
+    void Reset(size_t ordinal_count) {
+        if (stamps_.size() < ordinal_count) {
+            stamps_.resize(ordinal_count, 0);
+            relevances_.resize(ordinal_count);
+        }
+        if (stamp_ >= std::numeric_limits<uint32_t>::max() - 2) {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            stamp_ = 0;
+        }
+        // Метка stamp_ - документ набран, stamp_ + 1 - документ исключён минус-словом
+        stamp_ += 2;
+        touched_.clear();
+    }
+
+    void Add(DocumentOrdinal ordinal, double relevance) {
+        uint32_t& stamp = stamps_[ordinal];
+        if (stamp == stamp_) {
+            relevances_[ordinal] += relevance;
+        } else if (stamp != stamp_ + 1) {
+            stamp = stamp_;
+            relevances_[ordinal] = relevance;
+            touched_.push_back(ordinal);
+        }
+    }
+
+    void Exclude(DocumentOrdinal ordinal) {
+        stamps_[ordinal] = stamp_ + 1;
+    }
+
+    bool IsMatched(DocumentOrdinal ordinal) const {
+        return stamps_[ordinal] == stamp_;
+    }
+
+    double GetRelevance(DocumentOrdinal ordinal) const {
+        return relevances_[ordinal];
+    }
+
+    const std::vector<DocumentOrdinal>& GetTouched() const {
+        return touched_;
+    }
+
+private:
+    std::vector<uint32_t> stamps_;
+    std::vector<double> relevances_;
+    std::vector<DocumentOrdinal> touched_;
+    uint32_t stamp_ = 0;
+};
@@ -1,43 +1,92 @@
 #include "request_queue.h"
 
+#include <stdexcept>
+#include <thread>
+
 using namespace std;
 
-RequestQueue::RequestQueue(const SearchServer& search_server)
+RequestQueue::RequestQueue(const SearchServer& search_server, RequestQueueOptions options)
         : search_server_(search_server)
-        , requests_without_resault_(0)
-        , current_time_(0){
+        , options_(move(options)) {
+    if (options_.bucket_count == 0 || options_.window < options_.bucket_count * Clock::duration(1)) {
+        throw invalid_argument("Request queue window must hold at least one clock tick per bucket");
     }
-    vector<Document> RequestQueue::AddFindRequest(string_view raw_query, DocumentStatus status) {
-        ++current_time_;
-        const auto result = search_server_.FindTopDocuments(raw_query, status);
-        RemoveOld();
-        uint64_t res = result.size();
-        requests_.push_back({current_time_, res});
-        if (0 == res) {
-            ++requests_without_resault_;
+    bucket_width_ = options_.window / options_.bucket_count;
+    start_ = Now();
+    buckets_ = make_unique<Bucket[]>(options_.bucket_count);
+}
+
+vector<Document> RequestQueue::AddFindRequest(string_view raw_query, DocumentStatus status) {
+    const Clock::time_point start = Now();
+    vector<Document> documents = search_server_.FindTopDocuments(raw_query, status);
+    Record(start, documents.empty());
+    return documents;
+}
+
+vector<Document> RequestQueue::AddFindRequest(string_view raw_query) {
+    return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
+}
+
+int RequestQueue::GetNoResultRequests() const {
+    return GetStats().no_result_requests;
+}
+
+RequestStats RequestQueue::GetStats() const {
+    const uint64_t current_epoch = GetEpoch(Now());
+    RequestStats stats;
+    for (size_t index = 0; index < options_.bucket_count; ++index) {
+        const Bucket& bucket = buckets_[index];
+        const uint64_t epoch = bucket.epoch.load(memory_order_acquire);
+        // Счётчики читаются без остановки записи: запросы, завершающиеся сейчас, могут не попасть в сумму
+        if (epoch == 0 || (epoch & kResetting) != 0 || epoch > current_epoch || current_epoch - epoch >= options_.bucket_count) {
+            continue;
         }
-        return {};
+        stats.requests += bucket.requests.load(memory_order_relaxed);
+        stats.no_result_requests += bucket.no_result_requests.load(memory_order_relaxed);
+        bucket.latencies.AddTo(stats.latencies);
     }
-    vector<Document> RequestQueue::AddFindRequest(string_view raw_query) {
-        ++current_time_;
-        const auto result = search_server_.FindTopDocuments(raw_query);
-        RemoveOld();
-        uint64_t res = result.size();
-        requests_.push_back({current_time_, res});
-        if (0 == res) {
-            ++requests_without_resault_;
+    return stats;
+}
+
+RequestQueue::Clock::time_point RequestQueue::Now() const {
+    return options_.clock ? options_.clock() : Clock::now();
+}
+
+uint64_t RequestQueue::GetEpoch(Clock::time_point time) const {
+    // Отрезки нумеруются с единицы, чтобы 0 означал пустой интервал
+    return (time - start_) / bucket_width_ + 1;
+}
+
+RequestQueue::Bucket* RequestQueue::AcquireBucket(uint64_t epoch) {
+    Bucket& bucket = buckets_[epoch % options_.bucket_count];
+    uint64_t current = bucket.epoch.load(memory_order_acquire);
+    while (current != epoch) {
+        if ((current & kResetting) != 0) {
+            // Обнуление занимает несколько тысяч записей в память; оно бывает раз в отрезок
+            this_thread::yield();
+            current = bucket.epoch.load(memory_order_acquire);
+        } else if (current > epoch) {
+            return nullptr;
+        } else if (bucket.epoch.compare_exchange_weak(current, epoch | kResetting, memory_order_acquire)) {
+            bucket.requests.store(0, memory_order_relaxed);
+            bucket.no_result_requests.store(0, memory_order_relaxed);
+            bucket.latencies.Reset();
+            bucket.epoch.store(epoch, memory_order_release);
+            current = epoch;
         }
-        return {};
-    }
-    int RequestQueue::GetNoResultRequests() const {
-        return requests_without_resault_;
     }
+    return &bucket;
+}
 
-    void RequestQueue::RemoveOld(){
-        while (!requests_.empty() && min_in_day_ <= current_time_ - requests_.front().time) {
-            if (0 == requests_.front().results) {
-                --requests_without_resault_;
-            }
-            requests_.pop_front();
-        }
+void RequestQueue::Record(Clock::time_point start, bool is_empty) {
+    const Clock::time_point end = Now();
+    Bucket* bucket = AcquireBucket(GetEpoch(end));
+    if (!bucket) {
+        return;
+    }
+    bucket->requests.fetch_add(1, memory_order_relaxed);
+    if (is_empty) {
+        bucket->no_result_requests.fetch_add(1, memory_order_relaxed);
     }
+    bucket->latencies.Record(end - start);
+}
@@ -1,38 +1,76 @@
 #pragma once
 
-#include <deque>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "latency_histogram.h"
 #include "search_server.h"
 
+struct RequestQueueOptions {
+    // Статистика считается за последние window, окно сдвигается шагами window / bucket_count
+    std::chrono::steady_clock::duration window = std::chrono::hours(24);
+    size_t bucket_count = 96;
+    // Источник времени; по умолчанию steady_clock::now
+    std::function<std::chrono::steady_clock::time_point()> clock;
+};
+
+struct RequestStats {
+    uint64_t requests = 0;
+    uint64_t no_result_requests = 0;
+    // Время выполнения запросов
+    LatencyDistribution latencies;
+};
+
+// Статистика запросов к серверу в скользящем окне времени. Окно - кольцо интервалов по
+// монотонным часам: запрос увеличивает атомарные счётчики своего интервала, а интервал,
+// переходящий к новому отрезку времени, обнуляет тот поток, что первым до него дошёл.
+// Методы можно вызывать из разных потоков одновременно
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server);
+    explicit RequestQueue(const SearchServer& search_server, RequestQueueOptions options = {});
+
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate);
     std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentStatus status);
     std::vector<Document> AddFindRequest(std::string_view raw_query);
+
+    // Запросы без результатов в окне
     int GetNoResultRequests() const;
-    void RemoveOld();
+    RequestStats GetStats() const;
+
 private:
-    struct QueryResult {
-        uint64_t time;
-        uint64_t results;
+    using Clock = std::chrono::steady_clock;
+
+    struct alignas(64) Bucket {
+        // Номер отрезка времени, к которому относятся счётчики; 0 - интервал ещё пуст,
+        // kResetting - счётчики обнуляются для нового отрезка
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> no_result_requests{0};
+        LatencyHistogram latencies;
     };
-    std::deque<QueryResult> requests_;
-    const static int min_in_day_ = 1440;
+
+    static const uint64_t kResetting = uint64_t(1) << 63;
+
     const SearchServer& search_server_;
-    int requests_without_resault_;
-    uint64_t current_time_;
+    RequestQueueOptions options_;
+    Clock::duration bucket_width_;
+    Clock::time_point start_;
+    std::unique_ptr<Bucket[]> buckets_;
+
+    Clock::time_point Now() const;
+    uint64_t GetEpoch(Clock::time_point time) const;
+    // Интервал отрезка epoch; nullptr, если его место уже занял более поздний отрезок
+    Bucket* AcquireBucket(uint64_t epoch);
+    void Record(Clock::time_point start, bool is_empty);
 };
 
-    template <typename DocumentPredicate>
-    std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate) {
-        ++current_time_;
-        const auto result = search_server_.FindTopDocuments(raw_query, document_predicate);
-        RequestQueue::RemoveOld();
-        uint64_t res = result.size();
-        requests_.push_back({current_time_, res});
-        if (0 == res) {
-            ++requests_without_resault_;
-        }
-        return {};
-    }
+template <typename DocumentPredicate>
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate) {
+    const Clock::time_point start = Now();
+    std::vector<Document> documents = search_server_.FindTopDocuments(raw_query, document_predicate);
+    Record(start, documents.empty());
+    return documents;
+}
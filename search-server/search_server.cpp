@@ -2,29 +2,297 @@
 #include "document.h"
 #include "string_processing.h"
 
+#include <atomic>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
+
 using namespace std;
 
     void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings){
-        if (documents_.count(document_id) > 0 || !IsValidWord(document) || document_id < 0){
+        // Разбиение и проверка символов выполняются за один проход по тексту
+        vector<string_view> words;
+        if (FindOrdinal(document_id) != IndexSnapshot::kNoOrdinal || document_id < 0 || !SplitIntoWordsNoStop(document, words)){
             throw invalid_argument("Invalid symbols, word with minus-symbols only or invalid document id!");
         }
+        CheckNotDuplicate(words);
+        DetachSnapshot();
+        generation_ = NextGeneration();
+        if (mutation_log_) {
+            mutation_log_->LogAdd(document_id, document, status, ratings);
+        }
 
-        auto [id_, data_] = documents_.emplace(document_id, DocumentData{
-            string(document), ComputeAverageRating(ratings), status
-        });
+        const DocumentOrdinal ordinal = GetOrdinalCount();
+        vector<TermId> term_ids;
+        term_ids.reserve(words.size());
+        for (string_view word : words){
+            term_ids.push_back(dictionary_.Intern(word));
+        }
+        sort(term_ids.begin(), term_ids.end());
+        ReserveTermIds();
 
+        const double inverse_word_count = 1.0 / words.size();
+        for (auto begin = term_ids.begin(); begin != term_ids.end();){
+            const auto end = upper_bound(begin, term_ids.end(), *begin);
+            const uint32_t count = end - begin;
+            forward_term_ids_.push_back(*begin);
+            forward_term_counts_.push_back(count);
+            PostingList& postings = postings_[*begin];
+            postings.Append(ordinal, count);
+            TermBounds& bounds = term_bounds_[*begin];
+            bounds.log_document_freq = log(postings.Size());
+            bounds.max_term_freq = max(bounds.max_term_freq, count * inverse_word_count);
+            begin = end;
+        }
+        forward_offsets_.push_back(forward_term_ids_.size());
+
+        document_ids_.push_back(document_id);
+        ratings_.push_back(ComputeAverageRating(ratings));
+        statuses_.push_back(status);
+        SetStatusBits(ordinal, status);
+        inverse_word_counts_.push_back(inverse_word_count);
+        document_ordinals_.emplace(document_id, ordinal);
         doc_ids_set_.insert(document_id);
-        const auto words = SplitIntoWordsNoStop(id_-> second.data_string_);
-        const double inv_word_count = 1.0 / words.size();
-        for (auto word : words){
-            word_frequencies_[document_id][word] += inv_word_count;
-            word_to_document_freqs_[word][document_id] += inv_word_count;
+        log_document_count_ = log(GetDocumentCount());
+        if (duplicate_policy_ != DuplicatePolicy::ALLOW) {
+            RegisterFingerprint(ordinal, ComputeDocumentFingerprint(ordinal));
         }
+    }
+
+    void SearchServer::AddDocuments(const vector<NewDocument>& documents) {
+        AddDocuments(execution::seq, documents);
+    }
+
+    void SearchServer::AddDocuments(const execution::sequenced_policy&, const vector<NewDocument>& documents) {
+        AddDocumentsImpl(execution::seq, documents);
+    }
 
+    void SearchServer::AddDocuments(const execution::parallel_policy&, const vector<NewDocument>& documents) {
+        AddDocumentsImpl(execution::par, documents);
     }
 
-    vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status) const {
-        return FindTopDocuments(execution::seq, raw_query, status);
+    template <typename ExecutionPolicy>
+    void SearchServer::ValidateNewDocuments(ExecutionPolicy policy, const vector<NewDocument>& documents) const {
+        unordered_set<int> batch_ids;
+        batch_ids.reserve(documents.size());
+        for (const NewDocument& document : documents) {
+            if (FindOrdinal(document.id) != IndexSnapshot::kNoOrdinal || !batch_ids.insert(document.id).second || document.id < 0){
+                throw invalid_argument("Invalid symbols, word with minus-symbols only or invalid document id!");
+            }
+        }
+        if (!all_of(policy, documents.begin(), documents.end(),
+                    [](const NewDocument& document) { return IsValidWord(document.text); })) {
+            throw invalid_argument("Invalid symbols, word with minus-symbols only or invalid document id!");
+        }
+        if (duplicate_policy_ != DuplicatePolicy::REJECT) {
+            return;
+        }
+        // Различные слова документов пачки по возрастанию: дубликаты ищутся и в индексе, и в самой пачке
+        vector<vector<string_view>> unique_words(documents.size());
+        vector<Fingerprint> fingerprints(documents.size());
+        vector<size_t> indexes(documents.size());
+        iota(indexes.begin(), indexes.end(), 0);
+        for_each(policy, indexes.begin(), indexes.end(),
+                 [&](size_t index) {
+                     vector<string_view>& words = unique_words[index];
+                     SplitIntoWordsNoStop(documents[index].text, words);
+                     sort(words.begin(), words.end());
+                     words.erase(unique(words.begin(), words.end()), words.end());
+                     for (string_view word : words) {
+                         fingerprints[index] += ComputeWordFingerprint(word);
+                     }
+                 });
+        unordered_multimap<Fingerprint, size_t, FingerprintHasher> batch_fingerprints;
+        for (size_t index = 0; index < documents.size(); ++index) {
+            const auto [first, last] = batch_fingerprints.equal_range(fingerprints[index]);
+            const bool is_batch_duplicate = any_of(first, last, [&](const auto& entry) {
+                return unique_words[entry.second] == unique_words[index];
+            });
+            if (is_batch_duplicate || FindDuplicateOrdinal(unique_words[index]) != IndexSnapshot::kNoOrdinal) {
+                throw invalid_argument("Document duplicates an existing document!");
+            }
+            batch_fingerprints.emplace(fingerprints[index], index);
+        }
+    }
+
+    template void SearchServer::ValidateNewDocuments(execution::sequenced_policy, const vector<NewDocument>&) const;
+    template void SearchServer::ValidateNewDocuments(execution::parallel_policy, const vector<NewDocument>&) const;
+
+    template <typename ExecutionPolicy>
+    void SearchServer::AddDocumentsImpl(ExecutionPolicy policy, const vector<NewDocument>& documents) {
+        ValidateNewDocuments(policy, documents);
+        if (documents.empty()) {
+            return;
+        }
+        DetachSnapshot();
+        generation_ = NextGeneration();
+        if (mutation_log_) {
+            for (const NewDocument& document : documents) {
+                mutation_log_->LogAdd(document.id, document.text, document.status, document.ratings);
+            }
+        }
+
+        // Пачка делится на части подряд идущих документов; каждая часть разбирается
+        // в своём потоке со своим локальным словарём и строит частичные списки вхождений
+        struct BatchPart {
+            size_t first;
+            size_t last;
+            unordered_map<string_view, TermId> local_ids;
+            vector<string_view> words;
+            // Термы документов части (сначала локальные, затем глобальные номера) с числом вхождений
+            vector<pair<TermId, uint32_t>> terms;
+            vector<size_t> term_offsets;
+            vector<double> inverse_word_counts;
+            // Частичные списки по локальному номеру терма: записи терма local_id
+            // лежат в [posting_offsets[local_id], posting_offsets[local_id + 1])
+            vector<size_t> posting_offsets;
+            vector<DocumentOrdinal> posting_ordinals;
+            vector<uint32_t> posting_counts;
+            // Пары (глобальный номер, локальный номер) по возрастанию глобального
+            vector<pair<TermId, TermId>> global_ids;
+        };
+        const bool is_parallel = is_same_v<ExecutionPolicy, execution::parallel_policy>;
+        // Части одинакового размера, по одной на поток: больше частей - больше повторов слов в локальных словарях
+        const size_t part_count = is_parallel ? min<size_t>(documents.size(), max(1u, thread::hardware_concurrency())) : 1;
+        const size_t part_size = (documents.size() + part_count - 1) / part_count;
+        vector<BatchPart> parts((documents.size() + part_size - 1) / part_size);
+        for (size_t index = 0; index < parts.size(); ++index) {
+            parts[index].first = index * part_size;
+            parts[index].last = min(documents.size(), (index + 1) * part_size);
+        }
+
+        const DocumentOrdinal first_ordinal = GetOrdinalCount();
+        for_each(policy, parts.begin(), parts.end(), [this, &documents, first_ordinal](BatchPart& part) {
+            part.term_offsets.push_back(0);
+            vector<TermId> document_terms;
+            vector<string_view> words;
+            for (size_t index = part.first; index < part.last; ++index) {
+                SplitIntoWordsNoStop(documents[index].text, words);
+                document_terms.clear();
+                for (string_view word : words) {
+                    const auto [it, inserted] = part.local_ids.emplace(word, part.words.size());
+                    if (inserted) {
+                        part.words.push_back(word);
+                    }
+                    document_terms.push_back(it->second);
+                }
+                sort(document_terms.begin(), document_terms.end());
+                for (auto begin = document_terms.begin(); begin != document_terms.end();) {
+                    const auto end = upper_bound(begin, document_terms.end(), *begin);
+                    part.terms.emplace_back(*begin, end - begin);
+                    begin = end;
+                }
+                part.term_offsets.push_back(part.terms.size());
+                part.inverse_word_counts.push_back(1.0 / words.size());
+            }
+
+            // Раскладка подсчётом по локальным номерам сохраняет порядок документов внутри терма
+            part.posting_offsets.assign(part.words.size() + 1, 0);
+            for (const auto& [local_id, count] : part.terms) {
+                ++part.posting_offsets[local_id + 1];
+            }
+            partial_sum(part.posting_offsets.begin(), part.posting_offsets.end(), part.posting_offsets.begin());
+            vector<size_t> positions(part.posting_offsets.begin(), part.posting_offsets.end() - 1);
+            part.posting_ordinals.resize(part.terms.size());
+            part.posting_counts.resize(part.terms.size());
+            for (size_t document = 0; document + 1 < part.term_offsets.size(); ++document) {
+                const DocumentOrdinal ordinal = first_ordinal + part.first + document;
+                for (size_t i = part.term_offsets[document]; i < part.term_offsets[document + 1]; ++i) {
+                    const size_t position = positions[part.terms[i].first]++;
+                    part.posting_ordinals[position] = ordinal;
+                    part.posting_counts[position] = part.terms[i].second;
+                }
+            }
+        });
+
+        // Словарь общий, поэтому слова частей регистрируются в нём последовательно,
+        // но каждое различное слово части - один раз
+        for (BatchPart& part : parts) {
+            part.global_ids.reserve(part.words.size());
+            for (TermId local_id = 0; local_id < part.words.size(); ++local_id) {
+                part.global_ids.emplace_back(dictionary_.Intern(part.words[local_id]), local_id);
+            }
+        }
+        ReserveTermIds();
+
+        for_each(policy, parts.begin(), parts.end(), [](BatchPart& part) {
+            vector<TermId> local_to_global(part.global_ids.size());
+            for (const auto& [global_id, local_id] : part.global_ids) {
+                local_to_global[local_id] = global_id;
+            }
+            for (size_t document = 0; document + 1 < part.term_offsets.size(); ++document) {
+                const auto begin = part.terms.begin() + part.term_offsets[document];
+                const auto end = part.terms.begin() + part.term_offsets[document + 1];
+                for (auto it = begin; it != end; ++it) {
+                    it->first = local_to_global[it->first];
+                }
+                sort(begin, end);
+            }
+            sort(part.global_ids.begin(), part.global_ids.end());
+        });
+
+        // Слияние частичных списков за один проход: группы термов обрабатываются независимо,
+        // внутри терма части идут по возрастанию номеров документов
+        const TermId term_group_size = 64;
+        vector<TermId> term_groups;
+        for (TermId term_id = 0; term_id < dictionary_.GetIdBound(); term_id += term_group_size) {
+            term_groups.push_back(term_id);
+        }
+        for_each(policy, term_groups.begin(), term_groups.end(), [this, &parts, term_group_size, first_ordinal](TermId first_term) {
+            const TermId last_term = first_term + term_group_size;
+            for (const BatchPart& part : parts) {
+                auto it = lower_bound(part.global_ids.begin(), part.global_ids.end(), make_pair(first_term, TermId(0)));
+                for (; it != part.global_ids.end() && it->first < last_term; ++it) {
+                    PostingList& postings = postings_[it->first];
+                    TermBounds& bounds = term_bounds_[it->first];
+                    for (size_t i = part.posting_offsets[it->second]; i < part.posting_offsets[it->second + 1]; ++i) {
+                        const DocumentOrdinal ordinal = part.posting_ordinals[i];
+                        postings.Append(ordinal, part.posting_counts[i]);
+                        const double term_freq = part.posting_counts[i] * part.inverse_word_counts[ordinal - first_ordinal - part.first];
+                        bounds.max_term_freq = max(bounds.max_term_freq, term_freq);
+                    }
+                    bounds.log_document_freq = log(postings.Size());
+                }
+            }
+        });
+
+        for (const BatchPart& part : parts) {
+            for (size_t document = 0; document + 1 < part.term_offsets.size(); ++document) {
+                for (size_t i = part.term_offsets[document]; i < part.term_offsets[document + 1]; ++i) {
+                    forward_term_ids_.push_back(part.terms[i].first);
+                    forward_term_counts_.push_back(part.terms[i].second);
+                }
+                forward_offsets_.push_back(forward_term_ids_.size());
+                inverse_word_counts_.push_back(part.inverse_word_counts[document]);
+            }
+        }
+        for (size_t index = 0; index < documents.size(); ++index) {
+            const NewDocument& document = documents[index];
+            document_ids_.push_back(document.id);
+            ratings_.push_back(ComputeAverageRating(document.ratings));
+            statuses_.push_back(document.status);
+            SetStatusBits(first_ordinal + index, document.status);
+            document_ordinals_.emplace(document.id, first_ordinal + index);
+            doc_ids_set_.insert(document.id);
+        }
+        log_document_count_ = log(GetDocumentCount());
+        if (duplicate_policy_ != DuplicatePolicy::ALLOW) {
+            for (size_t index = 0; index < documents.size(); ++index) {
+                RegisterFingerprint(first_ordinal + index, ComputeDocumentFingerprint(first_ordinal + index));
+            }
+        }
+    }
+
+    vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_result_count) const {
+        return FindTopDocuments(execution::seq, raw_query, status, max_result_count);
+    }
+
+    vector<Document> SearchServer::FindTopDocuments(string_view raw_query, const DocumentFilter& filter, size_t max_result_count) const {
+        return FindTopDocuments(execution::seq, raw_query, filter, max_result_count);
+    }
+
+    vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, DocumentStatus status, size_t max_result_count) const {
+        return FindTopDocuments(execution::seq, query, status, max_result_count);
     }
 
     vector<Document> SearchServer::FindTopDocuments(string_view raw_query) const {
@@ -32,7 +300,7 @@ using namespace std;
     }
 
     int SearchServer::GetDocumentCount() const {
-        return documents_.size();
+        return snapshot_ ? snapshot_->GetDocumentCount() : document_ordinals_.size();
     }
 
     MatchDocumentType SearchServer::MatchDocument(string_view raw_query, int document_id) const {
@@ -40,60 +308,64 @@ using namespace std;
     }
 
     MatchDocumentType SearchServer::MatchDocument(const execution::sequenced_policy&, string_view raw_query, int document_id) const {
-        if (documents_.count(document_id) <= 0 || document_id < 0) {
+        const DocumentOrdinal ordinal = FindOrdinal(document_id);
+        if (ordinal == IndexSnapshot::kNoOrdinal) {
             throw std::invalid_argument("The document ID does not exist"s);
         }
-        vector<string_view> matched_words;
-        const Query query = ParseQuery(raw_query);
-        for (string_view word : query.minus_words){
-            if (word_to_document_freqs_.count(word) == 0){
-                continue;
-            }
-            if (word_to_document_freqs_.at(word).count(document_id)){
-                return { {}, documents_.at(document_id).status };
-                break;
+        return MatchQuery(ParseQuery(raw_query), ordinal);
+    }
+
+    MatchDocumentType SearchServer::MatchDocument(const PreparedQuery& query, int document_id) const {
+        const DocumentOrdinal ordinal = FindOrdinal(document_id);
+        if (ordinal == IndexSnapshot::kNoOrdinal) {
+            throw std::invalid_argument("The document ID does not exist"s);
+        }
+        if (query.generation_ != generation_) {
+            return MatchQuery(query.query_, ordinal);
+        }
+        for (const TermId term_id : query.minus_term_ids_) {
+            if (HasTermId(ordinal, term_id)) {
+                return { vector<string_view>{}, statuses_[ordinal] };
             }
         }
 
-        for (string_view word : query.plus_words){
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            if (word_to_document_freqs_.at(word).count(document_id)) {
-                matched_words.push_back(word);
+        vector<string_view> matched_words;
+        for (size_t index = 0; index < query.query_.plus_words.size(); ++index) {
+            if (HasTermId(ordinal, query.plus_term_ids_[index])) {
+                matched_words.push_back(query.query_.plus_words[index]);
             }
         }
-        return { matched_words, documents_.at(document_id).status };
+        return { matched_words, statuses_[ordinal] };
     }
 
     MatchDocumentType SearchServer::MatchDocument(const execution::parallel_policy&, string_view raw_query, int document_id) const {
+        // В запросе единицы слов: задачи для них обошлись бы дороже самих проверок
+        return MatchDocument(execution::seq, raw_query, document_id);
+    }
 
-        if (documents_.count(document_id) <= 0 || document_id < 0) {
-            throw std::invalid_argument("The document ID does not exist"s);
+    MatchDocumentType SearchServer::MatchQuery(const Query& query, DocumentOrdinal ordinal) const {
+        // Минус-слова проверяются первыми: документ с любым из них не сопоставляется
+        for (string_view word : query.minus_words) {
+            if (HasTerm(ordinal, word)) {
+                return { vector<string_view>{}, statuses_[ordinal] };
+            }
         }
 
-        const Query& query = ParseQuery(raw_query);
-
-        const auto& lambda = [this, document_id](string_view word) {
-            const auto temp = word_to_document_freqs_.find(word);
-            return temp != word_to_document_freqs_.end() && temp->second.count(document_id);
-        };
-
-        if (any_of(execution::par, query.minus_words.begin(), query.minus_words.end(), lambda)) {
-            return { {}, documents_.at(document_id).status };
+        vector<string_view> matched_words;
+        for (string_view word : query.plus_words) {
+            if (HasTerm(ordinal, word)) {
+                matched_words.push_back(word);
+            }
         }
-
-        vector<string_view> matched_words(query.plus_words.size());
-
-        auto end = copy_if(execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(), lambda);
-        sort(matched_words.begin(), end);
-        end = unique(execution::par, matched_words.begin(), end);
-        matched_words.erase(end, matched_words.end());
-
-        return { matched_words, documents_.at(document_id).status };
+        return { matched_words, statuses_[ordinal] };
     }
 
     set<int>::iterator SearchServer::begin(){
+        // Для открытого снимка множество идентификаторов строится при первом обходе
+        if (snapshot_ && doc_ids_set_.size() != snapshot_->GetDocumentCount()) {
+            const int* ids = snapshot_->GetSortedDocumentIds();
+            doc_ids_set_ = set<int>(ids, ids + snapshot_->GetDocumentCount());
+        }
         return doc_ids_set_.begin();
     }
 
@@ -102,23 +374,19 @@ using namespace std;
     }
 
     bool SearchServer::IsValidWord(string_view word){
-        return none_of(word.begin(), word.end(), [](char c) {
-                return c >= '\0' && c < ' ';
-            });
+        return HasNoControlCharacters(word);
     }
 
     bool SearchServer::IsStopWord(string_view word) const {
         return stop_words_.count(word) > 0;
     }
 
-    vector<string_view> SearchServer::SplitIntoWordsNoStop(string_view text) const {
-        vector<string_view> words;
-        for (string_view& word : SplitIntoWords(text)){
-            if (!IsStopWord(word)) {
-                words.push_back(word);
-            }
+    bool SearchServer::SplitIntoWordsNoStop(string_view text, vector<string_view>& words) const {
+        const bool is_valid = SplitIntoWords(text, words);
+        if (!stop_words_.empty()) {
+            words.erase(remove_if(words.begin(), words.end(), [this](string_view word) { return IsStopWord(word); }), words.end());
         }
-        return words;
+        return is_valid;
     }
 
     int SearchServer::ComputeAverageRating(const vector<int>& ratings){
@@ -134,9 +402,6 @@ using namespace std;
 
     SearchServer::QueryWord SearchServer::ParseQueryWord(string_view& text) const {
         bool is_minus = false;
-        if(!IsValidWord(text)){
-            throw invalid_argument("Invalid symbols or word with minus-symbols only!");
-        }
         if (text[0] == '-') {
             if(!text.substr(1).empty() && text[1] != '-'){
                 is_minus = true;
@@ -150,8 +415,14 @@ using namespace std;
     }
 
     SearchServer::Query SearchServer::ParseQuery(string_view text) const {
+        QueryStageTimer timer(QueryStage::PARSE);
         Query query;
-        for (string_view& word : SplitIntoWords(text)){
+        // Управляющие символы проверяются при разбиении, а не отдельно в каждом слове
+        static thread_local vector<string_view> words;
+        if (!SplitIntoWords(text, words)){
+            throw invalid_argument("Invalid symbols or word with minus-symbols only!");
+        }
+        for (string_view& word : words){
             const QueryWord query_word = ParseQueryWord(word);
             if (!query_word.is_stop){
                 if (query_word.is_minus){
@@ -162,23 +433,390 @@ using namespace std;
                 }
             }
         }
-        sort(execution::par, query.minus_words.begin(), query.minus_words.end());
-        sort(execution::par, query.plus_words.begin(), query.plus_words.end());
+        // В запросе единицы слов: параллельная сортировка только добавила бы накладные расходы
+        sort(query.minus_words.begin(), query.minus_words.end());
+        sort(query.plus_words.begin(), query.plus_words.end());
         query.minus_words.erase(unique(query.minus_words.begin(), query.minus_words.end()),query.minus_words.end());
         query.plus_words.erase(unique(query.plus_words.begin(), query.plus_words.end()), query.plus_words.end());
         return query;
     }
 
-    double SearchServer::ComputeWordInverseDocumentFreq(string_view word) const {
-        return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+    size_t SearchServer::GetOrdinalCount() const {
+        return document_ids_.size();
+    }
+
+    DocumentOrdinal SearchServer::FindOrdinal(int document_id) const {
+        if (snapshot_) {
+            return snapshot_->FindOrdinal(document_id);
+        }
+        const auto it = document_ordinals_.find(document_id);
+        return it == document_ordinals_.end() ? IndexSnapshot::kNoOrdinal : it->second;
+    }
+
+    TermId SearchServer::FindTermId(string_view word) const {
+        return snapshot_ ? snapshot_->FindTerm(word) : dictionary_.Find(word);
+    }
+
+    string_view SearchServer::GetTerm(TermId term_id) const {
+        return snapshot_ ? snapshot_->GetTerm(term_id) : dictionary_.GetTerm(term_id);
+    }
+
+    TermId SearchServer::GetTermIdBound() const {
+        return snapshot_ ? snapshot_->GetTermIdBound() : dictionary_.GetIdBound();
+    }
+
+    PostingListView SearchServer::GetPostings(TermId term_id) const {
+        return snapshot_ ? snapshot_->GetPostings(term_id) : postings_[term_id].View();
+    }
+
+    bool SearchServer::HasTerm(DocumentOrdinal ordinal, string_view word) const {
+        return HasTermId(ordinal, FindTermId(word));
+    }
+
+    bool SearchServer::HasTermId(DocumentOrdinal ordinal, TermId term_id) const {
+        return term_id != TermDictionary::kNoTerm
+               && binary_search(forward_term_ids_.begin() + forward_offsets_[ordinal],
+                                forward_term_ids_.begin() + forward_offsets_[ordinal + 1], term_id);
+    }
+
+    double SearchServer::ComputeWordInverseDocumentFreq(size_t document_count, size_t document_freq) {
+        // Так же, как в GetInverseDocumentFreq, чтобы IDF совпадал до последнего бита
+        return log(document_count * 1.0) - log(document_freq * 1.0);
+    }
+
+    TermBounds SearchServer::GetTermBounds(TermId term_id) const {
+        return snapshot_ ? snapshot_->GetTermBounds()[term_id] : term_bounds_[term_id];
+    }
+
+    double SearchServer::GetInverseDocumentFreq(TermId term_id) const {
+        return log_document_count_ - GetTermBounds(term_id).log_document_freq;
+    }
+
+    void SearchServer::ReserveTermIds() {
+        if (postings_.size() < dictionary_.GetIdBound()) {
+            postings_.resize(dictionary_.GetIdBound());
+            term_bounds_.resize(dictionary_.GetIdBound());
+        }
+    }
+
+    TermStats SearchServer::GetTermStats(string_view word) const {
+        const TermId term_id = FindTermId(word);
+        if (term_id == TermDictionary::kNoTerm) {
+            return {};
+        }
+        return { GetPostings(term_id).Size(), GetInverseDocumentFreq(term_id), GetTermBounds(term_id).max_term_freq };
+    }
+
+    SearchServer::QueryPostings SearchServer::FindQueryPostings(const Query& query) const {
+        QueryPostings query_postings;
+        for (string_view word : query.plus_words) {
+            const TermId term_id = FindTermId(word);
+            if (term_id != TermDictionary::kNoTerm) {
+                const double inverse_document_freq = GetInverseDocumentFreq(term_id);
+                query_postings.plus.push_back({ GetPostings(term_id), inverse_document_freq,
+                                                inverse_document_freq * GetTermBounds(term_id).max_term_freq });
+            }
+        }
+        for (string_view word : query.minus_words) {
+            const TermId term_id = FindTermId(word);
+            if (term_id != TermDictionary::kNoTerm) {
+                query_postings.minus.push_back(GetPostings(term_id));
+            }
+        }
+        return query_postings;
+    }
+
+    SearchServer::QueryPostings SearchServer::FindQueryPostings(const PreparedQuery& query) const {
+        if (query.generation_ != generation_) {
+            return FindQueryPostings(query.query_);
+        }
+        QueryPostings query_postings;
+        for (size_t index = 0; index < query.plus_term_ids_.size(); ++index) {
+            const TermId term_id = query.plus_term_ids_[index];
+            if (term_id != TermDictionary::kNoTerm) {
+                const double inverse_document_freq = query.inverse_document_freqs_[index];
+                query_postings.plus.push_back({ GetPostings(term_id), inverse_document_freq,
+                                                inverse_document_freq * GetTermBounds(term_id).max_term_freq });
+            }
+        }
+        for (const TermId term_id : query.minus_term_ids_) {
+            if (term_id != TermDictionary::kNoTerm) {
+                query_postings.minus.push_back(GetPostings(term_id));
+            }
+        }
+        return query_postings;
+    }
+
+    SearchServer::QueryPostings SearchServer::FindQueryPostings(const PreparedQuery& query,
+                                                                const vector<double>& inverse_document_freqs) const {
+        if (inverse_document_freqs.size() != query.plus_term_ids_.size()) {
+            throw invalid_argument("Expected one inverse document frequency per plus word");
+        }
+        QueryPostings query_postings;
+        for (size_t index = 0; index < query.plus_term_ids_.size(); ++index) {
+            const TermId term_id = FindPreparedTermId(query, query.query_.plus_words[index], query.plus_term_ids_[index]);
+            if (term_id != TermDictionary::kNoTerm) {
+                query_postings.plus.push_back({ GetPostings(term_id), inverse_document_freqs[index],
+                                                inverse_document_freqs[index] * GetTermBounds(term_id).max_term_freq });
+            }
+        }
+        for (size_t index = 0; index < query.minus_term_ids_.size(); ++index) {
+            const TermId term_id = FindPreparedTermId(query, query.query_.minus_words[index], query.minus_term_ids_[index]);
+            if (term_id != TermDictionary::kNoTerm) {
+                query_postings.minus.push_back(GetPostings(term_id));
+            }
+        }
+        return query_postings;
+    }
+
+    TermId SearchServer::FindPreparedTermId(const PreparedQuery& query, string_view word, TermId prepared_term_id) const {
+        return query.generation_ == generation_ ? prepared_term_id : FindTermId(word);
+    }
+
+    vector<size_t> SearchServer::GetDocumentFreqs(const PreparedQuery& query) const {
+        vector<size_t> document_freqs;
+        document_freqs.reserve(query.plus_term_ids_.size());
+        for (size_t index = 0; index < query.plus_term_ids_.size(); ++index) {
+            const TermId term_id = FindPreparedTermId(query, query.query_.plus_words[index], query.plus_term_ids_[index]);
+            document_freqs.push_back(term_id == TermDictionary::kNoTerm ? 0 : GetPostings(term_id).Size());
+        }
+        return document_freqs;
+    }
+
+    SearchServer::PreparedQuery SearchServer::PrepareQuery(string_view raw_query) const {
+        PreparedQuery query;
+        auto text = make_shared<const string>(raw_query);
+        query.query_ = ParseQuery(*text);
+        query.text_ = move(text);
+        for (string_view word : query.query_.plus_words) {
+            const TermId term_id = FindTermId(word);
+            query.plus_term_ids_.push_back(term_id);
+            query.inverse_document_freqs_.push_back(
+                    term_id == TermDictionary::kNoTerm ? 0.0 : GetInverseDocumentFreq(term_id));
+        }
+        for (string_view word : query.query_.minus_words) {
+            query.minus_term_ids_.push_back(FindTermId(word));
+        }
+        query.generation_ = generation_;
+        return query;
+    }
+
+    uint64_t SearchServer::PreparedQuery::GetGeneration() const {
+        return generation_;
     }
 
-    const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const{
-        if (!documents_.count(document_id)) {
-            static map<string_view, double> empty;
-            return empty;
+    SearchServer::OrdinalFilter SearchServer::MakeOrdinalFilter(const DocumentFilter& filter) const {
+        OrdinalFilter ordinal_filter;
+        if (filter.status) {
+            ordinal_filter.statuses = &status_bitmaps_[static_cast<size_t>(*filter.status)];
+        }
+        if (filter.min_rating != numeric_limits<int>::min() || filter.max_rating != numeric_limits<int>::max()) {
+            ordinal_filter.ratings = ratings_.data();
+            ordinal_filter.min_rating = filter.min_rating;
+            ordinal_filter.max_rating = filter.max_rating;
         }
-        return word_frequencies_.at(document_id);
+        return ordinal_filter;
+    }
+
+    RelevanceAccumulator& SearchServer::GetThreadAccumulator() {
+        static thread_local RelevanceAccumulator accumulator;
+        return accumulator;
+    }
+
+    vector<Document>& SearchServer::GetThreadDocuments() {
+        static thread_local vector<Document> documents;
+        return documents;
+    }
+
+    SearchServer::QueryCursors& SearchServer::GetThreadCursors() {
+        static thread_local QueryCursors cursors;
+        return cursors;
+    }
+
+    void SearchServer::CountQueryPostings(const QueryPostings& query_postings, optional<size_t> visited_postings) {
+        if (!QueryTrace::IsEnabled()) {
+            return;
+        }
+        size_t postings = 0;
+        for (const PlusPostings& plus : query_postings.plus) {
+            postings += plus.postings.Size();
+        }
+        const size_t visited = min(visited_postings.value_or(postings), postings);
+        QueryTrace::CountQuery(visited, postings - visited);
+    }
+
+    map<string_view, double> SearchServer::GetWordFrequencies(int document_id) const{
+        map<string_view, double> word_frequencies;
+        const DocumentOrdinal ordinal = FindOrdinal(document_id);
+        if (ordinal == IndexSnapshot::kNoOrdinal) {
+            return word_frequencies;
+        }
+        const double inv_word_count = inverse_word_counts_[ordinal];
+        for (uint64_t i = forward_offsets_[ordinal]; i < forward_offsets_[ordinal + 1]; ++i) {
+            double& term_freq = word_frequencies[GetTerm(forward_term_ids_[i])];
+            for (uint32_t occurrence = 0; occurrence < forward_term_counts_[i]; ++occurrence) {
+                term_freq += inv_word_count;
+            }
+        }
+        return word_frequencies;
+    }
+
+    vector<TermId> SearchServer::GetDocumentTermIds(int document_id) const {
+        const DocumentOrdinal ordinal = FindOrdinal(document_id);
+        if (ordinal == IndexSnapshot::kNoOrdinal) {
+            return {};
+        }
+        return { forward_term_ids_.begin() + forward_offsets_[ordinal], forward_term_ids_.begin() + forward_offsets_[ordinal + 1] };
+    }
+
+    IndexStats SearchServer::GetIndexStats() const {
+        IndexStats stats;
+        if (snapshot_) {
+            // Отображённые списки занимают ровно свой сжатый размер в файле
+            for (TermId term_id = 0; term_id < snapshot_->GetTermIdBound(); ++term_id) {
+                const PostingListView postings = snapshot_->GetPostings(term_id);
+                stats.term_count += postings.Empty() ? 0 : 1;
+                stats.posting_count += postings.Size();
+                stats.posting_bytes += postings.GetBlockCount() * sizeof(PostingBlock) + postings.GetDataSize()
+                                       + postings.GetTailSize() * (sizeof(DocumentOrdinal) + sizeof(uint32_t));
+            }
+            stats.dictionary_bytes = snapshot_->GetFileSize() - stats.posting_bytes;
+            return stats;
+        }
+        stats.term_count = dictionary_.Size();
+        for (const PostingList& postings : postings_) {
+            stats.posting_count += postings.Size();
+            stats.posting_bytes += postings.GetMemoryUsage();
+        }
+        stats.dictionary_bytes = dictionary_.GetMemoryUsage();
+        return stats;
+    }
+
+    void SearchServer::SaveSnapshot(const string& path) const {
+        SnapshotContent content;
+        content.stop_words.assign(stop_words_.begin(), stop_words_.end());
+        content.ordinal_count = GetOrdinalCount();
+        content.document_ids = document_ids_.data();
+        content.ratings = ratings_.data();
+        content.statuses = statuses_.data();
+        content.inverse_word_counts = inverse_word_counts_.data();
+        content.forward_offsets = forward_offsets_.data();
+        content.forward_term_ids = forward_term_ids_.data();
+        content.forward_term_counts = forward_term_counts_.data();
+        for (size_t index = 0; index < kDocumentStatusCount; ++index) {
+            content.status_bitmaps[index] = status_bitmaps_[index].GetWords();
+        }
+        const TermId term_id_bound = GetTermIdBound();
+        content.terms.reserve(term_id_bound);
+        content.postings.reserve(term_id_bound);
+        for (TermId term_id = 0; term_id < term_id_bound; ++term_id) {
+            content.terms.push_back(GetTerm(term_id));
+            content.postings.push_back(GetPostings(term_id));
+        }
+        content.term_bounds = snapshot_ ? snapshot_->GetTermBounds() : term_bounds_.data();
+        WriteIndexSnapshot(path, content);
+    }
+
+    SearchServer SearchServer::OpenSnapshot(const string& path, bool verify_checksum, bool verify_structure) {
+        SearchServer search_server;
+        search_server.snapshot_ = IndexSnapshot::Open(path, verify_checksum, verify_structure);
+        const IndexSnapshot& snapshot = *search_server.snapshot_;
+        for (string_view word : snapshot.GetStopWords()) {
+            search_server.stop_words_.emplace(word);
+        }
+        const size_t ordinal_count = snapshot.GetOrdinalCount();
+        const size_t forward_size = snapshot.GetForwardOffsets()[ordinal_count];
+        search_server.document_ids_ = MappedVector<int>(snapshot.GetDocumentIds(), ordinal_count);
+        search_server.ratings_ = MappedVector<int>(snapshot.GetRatings(), ordinal_count);
+        search_server.statuses_ = MappedVector<DocumentStatus>(snapshot.GetStatuses(), ordinal_count);
+        search_server.inverse_word_counts_ = MappedVector<double>(snapshot.GetInverseWordCounts(), ordinal_count);
+        search_server.forward_offsets_ = MappedVector<uint64_t>(snapshot.GetForwardOffsets(), ordinal_count + 1);
+        search_server.forward_term_ids_ = MappedVector<TermId>(snapshot.GetForwardTermIds(), forward_size);
+        search_server.forward_term_counts_ = MappedVector<uint32_t>(snapshot.GetForwardTermCounts(), forward_size);
+        search_server.log_document_count_ = log(snapshot.GetDocumentCount());
+        for (size_t index = 0; index < kDocumentStatusCount; ++index) {
+            search_server.status_bitmaps_[index] = OrdinalBitmap(snapshot.GetStatusBitmap(static_cast<DocumentStatus>(index)), ordinal_count);
+        }
+        return search_server;
+    }
+
+    void SearchServer::SetMutationLog(shared_ptr<MutationLog> mutation_log) {
+        mutation_log_ = move(mutation_log);
+    }
+
+    void SearchServer::CompactMutationLog(const string& snapshot_path) {
+        if (!mutation_log_) {
+            SaveSnapshot(snapshot_path);
+            return;
+        }
+        mutation_log_->Checkpoint([this, &snapshot_path] { SaveSnapshot(snapshot_path); });
+    }
+
+    void SearchServer::EnableQueryCache(QueryCacheOptions options) {
+        query_cache_ = make_shared<QueryCache>(options);
+    }
+
+    void SearchServer::DisableQueryCache() {
+        query_cache_.reset();
+    }
+
+    QueryCacheStats SearchServer::GetQueryCacheStats() const {
+        return query_cache_ ? query_cache_->GetStats() : QueryCacheStats{};
+    }
+
+    uint64_t SearchServer::GetGeneration() const {
+        return generation_;
+    }
+
+    void SearchServer::SetQueryEngine(QueryEngine query_engine) {
+        query_engine_ = query_engine;
+    }
+
+    QueryEngine SearchServer::GetQueryEngine() const {
+        return query_engine_;
+    }
+
+    uint64_t SearchServer::NextGeneration() {
+        static atomic<uint64_t> generation{0};
+        return generation.fetch_add(1) + 1;
+    }
+
+    void SearchServer::DetachSnapshot() {
+        if (!snapshot_) {
+            return;
+        }
+        const TermId term_id_bound = snapshot_->GetTermIdBound();
+        vector<string_view> terms;
+        terms.reserve(term_id_bound);
+        postings_.clear();
+        postings_.reserve(term_id_bound);
+        for (TermId term_id = 0; term_id < term_id_bound; ++term_id) {
+            terms.push_back(snapshot_->GetTerm(term_id));
+            postings_.emplace_back(snapshot_->GetPostings(term_id));
+        }
+        term_bounds_.assign(snapshot_->GetTermBounds(), snapshot_->GetTermBounds() + term_id_bound);
+        dictionary_.Assign(terms);
+
+        document_ordinals_.clear();
+        doc_ids_set_.clear();
+        for (DocumentOrdinal ordinal = 0; ordinal < GetOrdinalCount(); ++ordinal) {
+            if (document_ids_[ordinal] >= 0) {
+                document_ordinals_.emplace(document_ids_[ordinal], ordinal);
+                doc_ids_set_.insert(document_ids_[ordinal]);
+            }
+        }
+
+        document_ids_.Detach();
+        ratings_.Detach();
+        statuses_.Detach();
+        inverse_word_counts_.Detach();
+        forward_offsets_.Detach();
+        forward_term_ids_.Detach();
+        forward_term_counts_.Detach();
+        for (OrdinalBitmap& bitmap : status_bitmaps_) {
+            bitmap.Detach();
+        }
+        snapshot_.reset();
     }
 
     void SearchServer::RemoveDocument(int document_id) {
@@ -186,35 +824,491 @@ using namespace std;
     }
 
     void SearchServer::RemoveDocument(const execution::sequenced_policy&, int document_id) {
-        auto temp = find(doc_ids_set_.begin(), doc_ids_set_.end(), document_id);
+        RemoveDocumentsImpl(execution::seq, { document_id });
+    }
+
+    void SearchServer::RemoveDocument(const execution::parallel_policy&, int document_id) {
+        RemoveDocumentsImpl(execution::par, { document_id });
+    }
+
+    void SearchServer::RemoveDocuments(const vector<int>& document_ids) {
+        RemoveDocuments(execution::seq, document_ids);
+    }
+
+    void SearchServer::RemoveDocuments(const execution::sequenced_policy&, const vector<int>& document_ids) {
+        RemoveDocumentsImpl(execution::seq, document_ids);
+    }
 
-        if (temp == doc_ids_set_.end()) {
+    void SearchServer::RemoveDocuments(const execution::parallel_policy&, const vector<int>& document_ids) {
+        RemoveDocumentsImpl(execution::par, document_ids);
+    }
+
+    template <typename ExecutionPolicy>
+    void SearchServer::RemoveDocumentsImpl(ExecutionPolicy policy, vector<int> document_ids) {
+        vector<DocumentOrdinal> ordinals;
+        for (const int document_id : document_ids) {
+            const DocumentOrdinal ordinal = FindOrdinal(document_id);
+            if (ordinal != IndexSnapshot::kNoOrdinal) {
+                ordinals.push_back(ordinal);
+            }
+        }
+        sort(ordinals.begin(), ordinals.end());
+        ordinals.erase(unique(ordinals.begin(), ordinals.end()), ordinals.end());
+        if (ordinals.empty()) {
             return;
         }
-        else {
-            doc_ids_set_.erase(temp);
+        DetachSnapshot();
+        generation_ = NextGeneration();
+        if (mutation_log_) {
+            vector<int> removed_ids;
+            removed_ids.reserve(ordinals.size());
+            for (const DocumentOrdinal ordinal : ordinals) {
+                removed_ids.push_back(document_ids_[ordinal]);
+            }
+            mutation_log_->LogRemove(removed_ids);
+        }
+        if (duplicate_policy_ != DuplicatePolicy::ALLOW) {
+            for (const DocumentOrdinal ordinal : ordinals) {
+                UnregisterFingerprint(ordinal);
+            }
         }
 
-        documents_.erase(document_id);
-        for_each(word_to_document_freqs_.begin(), word_to_document_freqs_.end(),
-                  [&](auto& temp) {
-                    temp.second.erase(document_id);
-                  });
+        // Группируем удаляемые документы по термам через прямой индекс:
+        // затрагиваются только списки термов самих удаляемых документов
+        vector<tuple<TermId, DocumentOrdinal, double>> term_ordinals;
+        for (const DocumentOrdinal ordinal : ordinals) {
+            for (uint64_t i = forward_offsets_[ordinal]; i < forward_offsets_[ordinal + 1]; ++i) {
+                term_ordinals.emplace_back(forward_term_ids_[i], ordinal, forward_term_counts_[i] * inverse_word_counts_[ordinal]);
+            }
+        }
+        sort(term_ordinals.begin(), term_ordinals.end());
+
+        struct RemovedTerm {
+            TermId term_id;
+            vector<DocumentOrdinal> ordinals;
+            // Наибольшая частота терма среди удаляемых документов
+            double max_term_freq;
+        };
+        vector<RemovedTerm> removed_terms;
+        for (const auto& [term_id, ordinal, term_freq] : term_ordinals) {
+            if (removed_terms.empty() || removed_terms.back().term_id != term_id) {
+                removed_terms.push_back({ term_id, {}, 0.0 });
+            }
+            removed_terms.back().ordinals.push_back(ordinal);
+            removed_terms.back().max_term_freq = max(removed_terms.back().max_term_freq, term_freq);
+        }
+
+        for_each(policy, removed_terms.begin(), removed_terms.end(),
+                 [this](RemovedTerm& removed_term) {
+                     PostingList& postings = postings_[removed_term.term_id];
+                     postings.EraseAll(removed_term.ordinals);
+                     TermBounds& bounds = term_bounds_[removed_term.term_id];
+                     if (postings.Empty()) {
+                         bounds = {};
+                         return;
+                     }
+                     bounds.log_document_freq = log(postings.Size());
+                     // Список просматривается заново, только если удалён документ с наибольшей частотой
+                     // и список короткий: иначе удаление стоило бы O(длины списка)
+                     if (removed_term.max_term_freq >= bounds.max_term_freq && postings.Size() <= kExactTermBoundsPostings) {
+                         bounds.max_term_freq = 0;
+                         postings.ForEach(0, GetOrdinalCount(), [this, &bounds](DocumentOrdinal ordinal, uint32_t count) {
+                             bounds.max_term_freq = max(bounds.max_term_freq, count * inverse_word_counts_[ordinal]);
+                         });
+                     }
+                 });
+
+        for (const RemovedTerm& removed_term : removed_terms) {
+            if (postings_[removed_term.term_id].Empty()) {
+                postings_[removed_term.term_id] = PostingList();
+                dictionary_.Release(removed_term.term_id);
+            }
+        }
+
+        // Термы удалённых документов остаются в прямом индексе до уплотнения
+        for (const DocumentOrdinal ordinal : ordinals) {
+            document_ordinals_.erase(document_ids_[ordinal]);
+            doc_ids_set_.erase(document_ids_[ordinal]);
+            document_ids_.Set(ordinal, -1);
+            ratings_.Set(ordinal, 0);
+            statuses_.Set(ordinal, DocumentStatus::REMOVED);
+            SetStatusBits(ordinal, nullopt);
+        }
+        log_document_count_ = log(GetDocumentCount());
+
+        if (GetOrdinalCount() - document_ordinals_.size() > document_ordinals_.size()) {
+            CompactDocuments();
+        }
     }
 
-    void SearchServer::RemoveDocument(const execution::parallel_policy&, int document_id) {
-        auto temp = find(execution::par, doc_ids_set_.begin(), doc_ids_set_.end(), document_id);
+    void SearchServer::CompactDocuments() {
+        vector<DocumentOrdinal> new_ordinals(GetOrdinalCount());
+        vector<int> document_ids;
+        vector<int> ratings;
+        vector<DocumentStatus> statuses;
+        vector<double> inverse_word_counts;
+        vector<uint64_t> forward_offsets{ 0 };
+        vector<TermId> forward_term_ids;
+        vector<uint32_t> forward_term_counts;
+        for (DocumentOrdinal ordinal = 0; ordinal < GetOrdinalCount(); ++ordinal) {
+            if (document_ids_[ordinal] < 0) {
+                continue;
+            }
+            new_ordinals[ordinal] = document_ids.size();
+            document_ordinals_[document_ids_[ordinal]] = document_ids.size();
+            document_ids.push_back(document_ids_[ordinal]);
+            ratings.push_back(ratings_[ordinal]);
+            statuses.push_back(statuses_[ordinal]);
+            inverse_word_counts.push_back(inverse_word_counts_[ordinal]);
+            forward_term_ids.insert(forward_term_ids.end(), forward_term_ids_.begin() + forward_offsets_[ordinal],
+                                    forward_term_ids_.begin() + forward_offsets_[ordinal + 1]);
+            forward_term_counts.insert(forward_term_counts.end(), forward_term_counts_.begin() + forward_offsets_[ordinal],
+                                       forward_term_counts_.begin() + forward_offsets_[ordinal + 1]);
+            forward_offsets.push_back(forward_term_ids.size());
+        }
+        document_ids_.Assign(move(document_ids));
+        ratings_.Assign(move(ratings));
+        statuses_.Assign(move(statuses));
+        inverse_word_counts_.Assign(move(inverse_word_counts));
+        forward_offsets_.Assign(move(forward_offsets));
+        forward_term_ids_.Assign(move(forward_term_ids));
+        forward_term_counts_.Assign(move(forward_term_counts));
+        RebuildStatusBitmaps();
+        for (TermId term_id = 0; term_id < postings_.size(); ++term_id) {
+            PostingList& postings = postings_[term_id];
+            if (postings.Empty()) {
+                continue;
+            }
+            postings.Remap(new_ordinals);
+            // Границы, оставшиеся завышенными после удалений, снова становятся точными
+            TermBounds& bounds = term_bounds_[term_id];
+            bounds.max_term_freq = 0;
+            postings.ForEach(0, GetOrdinalCount(), [this, &bounds](DocumentOrdinal ordinal, uint32_t count) {
+                bounds.max_term_freq = max(bounds.max_term_freq, count * inverse_word_counts_[ordinal]);
+            });
+        }
+    }
+
+    void SearchServer::SetStatusBits(DocumentOrdinal ordinal, optional<DocumentStatus> status) {
+        for (size_t index = 0; index < kDocumentStatusCount; ++index) {
+            OrdinalBitmap& bitmap = status_bitmaps_[index];
+            bitmap.Resize(GetOrdinalCount());
+            if (status && static_cast<size_t>(*status) == index) {
+                bitmap.Set(ordinal);
+            } else {
+                bitmap.Reset(ordinal);
+            }
+        }
+    }
+
+    void SearchServer::RebuildStatusBitmaps() {
+        for (OrdinalBitmap& bitmap : status_bitmaps_) {
+            bitmap.Clear();
+            bitmap.Resize(GetOrdinalCount());
+        }
+        for (DocumentOrdinal ordinal = 0; ordinal < GetOrdinalCount(); ++ordinal) {
+            if (document_ids_[ordinal] >= 0) {
+                status_bitmaps_[static_cast<size_t>(statuses_[ordinal])].Set(ordinal);
+            }
+        }
+    }
+
+    vector<int> SearchServer::FindDuplicates() const {
+        return FindDuplicates(execution::seq);
+    }
+
+    vector<int> SearchServer::FindDuplicates(const execution::sequenced_policy&) const {
+        return FindDuplicatesImpl(execution::seq);
+    }
+
+    vector<int> SearchServer::FindDuplicates(const execution::parallel_policy&) const {
+        return FindDuplicatesImpl(execution::par);
+    }
+
+    vector<NearDuplicate> SearchServer::FindNearDuplicates(const NearDuplicateOptions& options) const {
+        return FindNearDuplicates(execution::seq, options);
+    }
+
+    vector<NearDuplicate> SearchServer::FindNearDuplicates(const execution::sequenced_policy&, const NearDuplicateOptions& options) const {
+        return FindNearDuplicatesImpl(execution::seq, options);
+    }
+
+    vector<NearDuplicate> SearchServer::FindNearDuplicates(const execution::parallel_policy&, const NearDuplicateOptions& options) const {
+        return FindNearDuplicatesImpl(execution::par, options);
+    }
+
+    void SearchServer::SetDuplicatePolicy(DuplicatePolicy duplicate_policy) {
+        if (duplicate_policy == DuplicatePolicy::ALLOW) {
+            document_fingerprints_.clear();
+            duplicate_ids_.clear();
+        } else if (duplicate_policy_ == DuplicatePolicy::ALLOW) {
+            const vector<Fingerprint> fingerprints = ComputeDocumentFingerprints(execution::par);
+            for (DocumentOrdinal ordinal = 0; ordinal < GetOrdinalCount(); ++ordinal) {
+                if (document_ids_[ordinal] >= 0) {
+                    RegisterFingerprint(ordinal, fingerprints[ordinal]);
+                }
+            }
+        }
+        duplicate_policy_ = duplicate_policy;
+    }
+
+    DuplicatePolicy SearchServer::GetDuplicatePolicy() const {
+        return duplicate_policy_;
+    }
+
+    template <typename ExecutionPolicy>
+    vector<Fingerprint> SearchServer::ComputeTermFingerprints(ExecutionPolicy policy) const {
+        vector<TermId> term_ids(GetTermIdBound());
+        iota(term_ids.begin(), term_ids.end(), 0);
+        vector<Fingerprint> term_fingerprints(term_ids.size());
+        for_each(policy, term_ids.begin(), term_ids.end(),
+                 [this, &term_fingerprints](TermId term_id) {
+                     term_fingerprints[term_id] = ComputeWordFingerprint(GetTerm(term_id));
+                 });
+        return term_fingerprints;
+    }
+
+    template <typename ExecutionPolicy>
+    vector<Fingerprint> SearchServer::ComputeDocumentFingerprints(ExecutionPolicy policy) const {
+        // Отпечаток каждого терма считается один раз, отпечаток документа - сумма отпечатков его термов
+        const vector<Fingerprint> term_fingerprints = ComputeTermFingerprints(policy);
+        vector<DocumentOrdinal> ordinals(GetOrdinalCount());
+        iota(ordinals.begin(), ordinals.end(), 0);
+        vector<Fingerprint> fingerprints(ordinals.size());
+        for_each(policy, ordinals.begin(), ordinals.end(),
+                 [this, &term_fingerprints, &fingerprints](DocumentOrdinal ordinal) {
+                     if (document_ids_[ordinal] < 0) {
+                         return;
+                     }
+                     for (uint64_t i = forward_offsets_[ordinal]; i < forward_offsets_[ordinal + 1]; ++i) {
+                         fingerprints[ordinal] += term_fingerprints[forward_term_ids_[i]];
+                     }
+                 });
+        return fingerprints;
+    }
+
+    Fingerprint SearchServer::ComputeDocumentFingerprint(DocumentOrdinal ordinal) const {
+        Fingerprint fingerprint;
+        for (uint64_t i = forward_offsets_[ordinal]; i < forward_offsets_[ordinal + 1]; ++i) {
+            fingerprint += ComputeWordFingerprint(GetTerm(forward_term_ids_[i]));
+        }
+        return fingerprint;
+    }
+
+    bool SearchServer::HasSameTerms(DocumentOrdinal lhs, DocumentOrdinal rhs) const {
+        return equal(forward_term_ids_.begin() + forward_offsets_[lhs], forward_term_ids_.begin() + forward_offsets_[lhs + 1],
+                     forward_term_ids_.begin() + forward_offsets_[rhs], forward_term_ids_.begin() + forward_offsets_[rhs + 1]);
+    }
+
+    bool SearchServer::HasSameTerms(DocumentOrdinal ordinal, const vector<string_view>& unique_words) const {
+        if (forward_offsets_[ordinal + 1] - forward_offsets_[ordinal] != unique_words.size()) {
+            return false;
+        }
+        return all_of(unique_words.begin(), unique_words.end(), [this, ordinal](string_view word) {
+            const TermId term_id = FindTermId(word);
+            return term_id != TermDictionary::kNoTerm && HasTermId(ordinal, term_id);
+        });
+    }
 
-        if (temp == doc_ids_set_.end()) {
+    DocumentOrdinal SearchServer::FindDuplicateOrdinal(const vector<string_view>& unique_words) const {
+        Fingerprint fingerprint;
+        for (string_view word : unique_words) {
+            fingerprint += ComputeWordFingerprint(word);
+        }
+        const auto [first, last] = document_fingerprints_.equal_range(fingerprint);
+        for (auto it = first; it != last; ++it) {
+            const DocumentOrdinal ordinal = FindOrdinal(it->second);
+            if (HasSameTerms(ordinal, unique_words)) {
+                return ordinal;
+            }
+        }
+        return IndexSnapshot::kNoOrdinal;
+    }
+
+    void SearchServer::CheckNotDuplicate(const vector<string_view>& words) const {
+        if (duplicate_policy_ != DuplicatePolicy::REJECT) {
             return;
         }
-        else {
-            doc_ids_set_.erase(temp);
+        vector<string_view> unique_words = words;
+        sort(unique_words.begin(), unique_words.end());
+        unique_words.erase(unique(unique_words.begin(), unique_words.end()), unique_words.end());
+        if (FindDuplicateOrdinal(unique_words) != IndexSnapshot::kNoOrdinal) {
+            throw invalid_argument("Document duplicates an existing document!");
+        }
+    }
+
+    void SearchServer::RegisterFingerprint(DocumentOrdinal ordinal, const Fingerprint& fingerprint) {
+        // В группе одинаковых наборов слов дубликатами не считается только документ с наименьшим id
+        const int document_id = document_ids_[ordinal];
+        const auto [first, last] = document_fingerprints_.equal_range(fingerprint);
+        for (auto it = first; it != last; ++it) {
+            if (duplicate_ids_.count(it->second) == 0 && HasSameTerms(ordinal, FindOrdinal(it->second))) {
+                duplicate_ids_.insert(max(document_id, it->second));
+                break;
+            }
+        }
+        document_fingerprints_.emplace(fingerprint, document_id);
+    }
+
+    void SearchServer::UnregisterFingerprint(DocumentOrdinal ordinal) {
+        const int document_id = document_ids_[ordinal];
+        const bool is_duplicate = duplicate_ids_.erase(document_id) > 0;
+        const auto [first, last] = document_fingerprints_.equal_range(ComputeDocumentFingerprint(ordinal));
+        auto removed = last;
+        // Вместо удаляемого первого документа группы первым становится следующий по id
+        optional<int> next_document_id;
+        for (auto it = first; it != last; ++it) {
+            if (it->second == document_id) {
+                removed = it;
+            } else if (!is_duplicate && HasSameTerms(ordinal, FindOrdinal(it->second))
+                       && (!next_document_id || it->second < *next_document_id)) {
+                next_document_id = it->second;
+            }
         }
+        document_fingerprints_.erase(removed);
+        if (next_document_id) {
+            duplicate_ids_.erase(*next_document_id);
+        }
+    }
 
-        documents_.erase(document_id);
-        for_each(execution::par, word_to_document_freqs_.begin(), word_to_document_freqs_.end(),
-                  [&](auto& temp) {
-                    temp.second.erase(document_id);
+    template <typename ExecutionPolicy>
+    vector<int> SearchServer::FindDuplicatesImpl(ExecutionPolicy policy) const {
+        if (duplicate_policy_ != DuplicatePolicy::ALLOW) {
+            return { duplicate_ids_.begin(), duplicate_ids_.end() };
+        }
+        const vector<Fingerprint> fingerprints = ComputeDocumentFingerprints(policy);
+        vector<pair<Fingerprint, int>> documents;
+        documents.reserve(GetDocumentCount());
+        for (DocumentOrdinal ordinal = 0; ordinal < GetOrdinalCount(); ++ordinal) {
+            if (document_ids_[ordinal] >= 0) {
+                documents.emplace_back(fingerprints[ordinal], document_ids_[ordinal]);
+            }
+        }
+        sort(policy, documents.begin(), documents.end());
+
+        vector<int> duplicates;
+        vector<int> group_first_ids;
+        for (size_t begin = 0; begin < documents.size();) {
+            size_t end = begin + 1;
+            while (end < documents.size() && documents[end].first == documents[begin].first) {
+                ++end;
+            }
+            // Одинаковые отпечатки почти всегда означают одинаковые наборы слов, но это проверяется
+            group_first_ids.clear();
+            for (size_t index = begin; index < end; ++index) {
+                const int document_id = documents[index].second;
+                const DocumentOrdinal ordinal = FindOrdinal(document_id);
+                const bool is_duplicate = any_of(group_first_ids.begin(), group_first_ids.end(), [&](int first_id) {
+                    return HasSameTerms(ordinal, FindOrdinal(first_id));
+                });
+                if (is_duplicate) {
+                    duplicates.push_back(document_id);
+                } else {
+                    group_first_ids.push_back(document_id);
+                }
+            }
+            begin = end;
+        }
+        sort(duplicates.begin(), duplicates.end());
+        return duplicates;
+    }
+
+    template <typename ExecutionPolicy>
+    vector<NearDuplicate> SearchServer::FindNearDuplicatesImpl(ExecutionPolicy policy, const NearDuplicateOptions& options) const {
+        if (!(options.similarity_threshold > 0 && options.similarity_threshold <= 1) || options.band_count == 0 || options.band_size == 0) {
+            throw invalid_argument("Invalid near-duplicate search options");
+        }
+        const size_t hash_count = options.band_count * options.band_size;
+        const vector<Fingerprint> term_fingerprints = ComputeTermFingerprints(policy);
+        vector<DocumentOrdinal> ordinals;
+        for (DocumentOrdinal ordinal = 0; ordinal < GetOrdinalCount(); ++ordinal) {
+            if (document_ids_[ordinal] >= 0 && forward_offsets_[ordinal + 1] > forward_offsets_[ordinal]) {
+                ordinals.push_back(ordinal);
+            }
+        }
+
+        // Подпись документа - минимумы хеш-функций по его термам; ключ полосы - хеш её значений
+        struct BandKey {
+            uint64_t key;
+            DocumentOrdinal ordinal;
+
+            bool operator<(const BandKey& other) const {
+                return key != other.key ? key < other.key : ordinal < other.ordinal;
+            }
+        };
+        vector<size_t> indexes(ordinals.size());
+        iota(indexes.begin(), indexes.end(), 0);
+        vector<BandKey> band_keys(ordinals.size() * options.band_count);
+        for_each(policy, indexes.begin(), indexes.end(),
+                 [&](size_t index) {
+                     const DocumentOrdinal ordinal = ordinals[index];
+                     vector<uint64_t> signature(hash_count, numeric_limits<uint64_t>::max());
+                     for (uint64_t i = forward_offsets_[ordinal]; i < forward_offsets_[ordinal + 1]; ++i) {
+                         const Fingerprint& term_fingerprint = term_fingerprints[forward_term_ids_[i]];
+                         for (size_t hash = 0; hash < hash_count; ++hash) {
+                             signature[hash] = min(signature[hash], ComputeMinHash(term_fingerprint, hash));
+                         }
+                     }
+                     for (size_t band = 0; band < options.band_count; ++band) {
+                         uint64_t key = MixHash(band + 1);
+                         for (size_t row = 0; row < options.band_size; ++row) {
+                             key = MixHash(key ^ signature[band * options.band_size + row]);
+                         }
+                         band_keys[index * options.band_count + band] = { key, ordinal };
+                     }
+                 });
+        sort(policy, band_keys.begin(), band_keys.end());
+
+        vector<pair<DocumentOrdinal, DocumentOrdinal>> candidates;
+        for (size_t begin = 0; begin < band_keys.size();) {
+            size_t end = begin + 1;
+            while (end < band_keys.size() && band_keys[end].key == band_keys[begin].key) {
+                ++end;
+            }
+            for (size_t lhs = begin; lhs < end; ++lhs) {
+                for (size_t rhs = lhs + 1; rhs < end; ++rhs) {
+                    candidates.emplace_back(band_keys[lhs].ordinal, band_keys[rhs].ordinal);
+                }
+            }
+            begin = end;
+        }
+        sort(policy, candidates.begin(), candidates.end());
+        candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+        // Сходство кандидатов считается точно по прямому индексу: термы документа упорядочены
+        vector<double> similarities(candidates.size());
+        transform(policy, candidates.begin(), candidates.end(), similarities.begin(),
+                  [this](const pair<DocumentOrdinal, DocumentOrdinal>& candidate) {
+                      const auto [lhs, rhs] = candidate;
+                      uint64_t i = forward_offsets_[lhs];
+                      uint64_t j = forward_offsets_[rhs];
+                      size_t intersection = 0;
+                      while (i < forward_offsets_[lhs + 1] && j < forward_offsets_[rhs + 1]) {
+                          if (forward_term_ids_[i] < forward_term_ids_[j]) {
+                              ++i;
+                          } else if (forward_term_ids_[j] < forward_term_ids_[i]) {
+                              ++j;
+                          } else {
+                              ++intersection;
+                              ++i;
+                              ++j;
+                          }
+                      }
+                      const size_t union_size = (forward_offsets_[lhs + 1] - forward_offsets_[lhs])
+                                                + (forward_offsets_[rhs + 1] - forward_offsets_[rhs]) - intersection;
+                      return intersection * 1.0 / union_size;
                   });
+
+        vector<NearDuplicate> near_duplicates;
+        for (size_t index = 0; index < candidates.size(); ++index) {
+            if (similarities[index] >= options.similarity_threshold) {
+                const int lhs_id = document_ids_[candidates[index].first];
+                const int rhs_id = document_ids_[candidates[index].second];
+                near_duplicates.push_back({ min(lhs_id, rhs_id), max(lhs_id, rhs_id), similarities[index] });
+            }
+        }
+        sort(near_duplicates.begin(), near_duplicates.end(), [](const NearDuplicate& lhs, const NearDuplicate& rhs) {
+            return pair(lhs.document_id, lhs.similar_document_id) < pair(rhs.document_id, rhs.similar_document_id);
+        });
+        return near_duplicates;
     }
@@ -14,24 +14,103 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <map>
+#include <unordered_map>
 #include <utility>
 #include <execution>
 #include <random>
 #include <future>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <thread>
+#include <type_traits>
 
-#include "concurrent_map.h"
 #include "document.h"
+#include "document_fingerprint.h"
+#include "index_snapshot.h"
+#include "mapped_vector.h"
+#include "mutation_log.h"
+#include "ordinal_bitmap.h"
+#include "posting_list.h"
+#include "query_cache.h"
+#include "query_executor.h"
+#include "query_trace.h"
+#include "relevance_accumulator.h"
+#include "small_vector.h"
+#include "term_dictionary.h"
 #include "string_processing.h"
+#include "top_documents.h"
 #include "read_input_functions.h"
 #include "log_duration.h"
 
 const int kMaxResultDocumentCount = 5;
-const double kEpsilon = 1e-6;
+
+struct IndexStats {
+    size_t term_count = 0;
+    size_t posting_count = 0;
+    size_t posting_bytes = 0;
+    size_t dictionary_bytes = 0;
+};
+
+// Способ обхода списков вхождений при поиске; оба дают одинаковый top-K
+enum class QueryEngine {
+    // Слово за словом: все вхождения плюс-слов набираются в аккумулятор, затем отбирается top-K
+    TERM_AT_A_TIME,
+    // Документ за документом с отсечением WAND: документы, чья верхняя граница релевантности
+    // не дотягивает до худшего из уже набранных top-K, пропускаются без оценки
+    WAND,
+};
+
+// Проверка дубликатов при добавлении документов. Дубликат - документ с тем же набором слов,
+// что у документа с меньшим id
+enum class DuplicatePolicy {
+    // Без проверки, дубликаты ищет только FindDuplicates
+    ALLOW,
+    // Документ, повторяющий набор слов имеющегося, не добавляется: invalid_argument
+    REJECT,
+    // Документ добавляется, а дубликаты учитываются сразу: FindDuplicates обходится без просмотра индекса
+    FLAG,
+};
+
+struct NearDuplicateOptions {
+    // Наименьший коэффициент Жаккара наборов слов
+    double similarity_threshold = 0.8;
+    // Подпись MinHash из band_count * band_size значений делится на полосы; документы
+    // с совпадающей хотя бы одной полосой становятся кандидатами
+    size_t band_count = 16;
+    size_t band_size = 4;
+};
+
+struct NearDuplicate {
+    int document_id = 0;
+    // Больше document_id
+    int similar_document_id = 0;
+    double similarity = 0;
+};
+
+struct TermStats {
+    size_t document_freq = 0;
+    double inverse_document_freq = 0;
+    // Наибольшая частота слова в одном документе: inverse_document_freq * max_term_freq -
+    // верхняя граница вклада слова в релевантность любого документа. После удаления
+    // документов у длинных списков может быть завышена до уплотнения индекса
+    double max_term_freq = 0;
+};
 
 using MatchDocumentType = std::tuple<std::vector<std::string_view>, DocumentStatus>;
 
+// Документ для пакетного добавления; текст должен жить до конца вызова AddDocuments
+struct NewDocument {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
 class SearchServer {
 public:
     template <typename StringContainer>
@@ -41,15 +120,36 @@ public:
 
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // Пакетное добавление: вся пачка проверяется до изменения индекса (исключения те же,
+    // что у AddDocument), параллельная версия разбирает документы и строит списки вхождений
+    // частями в разных потоках, а затем сливает их в индекс за один проход
+    void AddDocuments(const std::vector<NewDocument>& documents);
+    void AddDocuments(const std::execution::sequenced_policy&, const std::vector<NewDocument>& documents);
+    void AddDocuments(const std::execution::parallel_policy&, const std::vector<NewDocument>& documents);
+    // Проверки AddDocuments без изменения индекса: бросает invalid_argument, если пачку нельзя добавить целиком
+    template <typename ExecutionPolicy>
+    void ValidateNewDocuments(ExecutionPolicy policy, const std::vector<NewDocument>& documents) const;
+
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+    // Статус и рейтинг проверяются по битовым картам и столбцам до подсчёта релевантности;
+    // DocumentFilter можно передать и вместо предиката в остальные перегрузки
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const DocumentFilter& filter,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
 
     template <typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy, std::string_view raw_query, DocumentPredicate document_predicate,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
     template <typename ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy, std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy, std::string_view raw_query, DocumentStatus status,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy, std::string_view raw_query, const DocumentFilter& filter,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy, std::string_view raw_query) const;
 
@@ -59,35 +159,207 @@ public:
     MatchDocumentType MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const;
     MatchDocumentType MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, int document_id) const;
 
+    // Запрос, разобранный один раз для многократного выполнения (определение ниже)
+    class PreparedQuery;
+    PreparedQuery PrepareQuery(std::string_view raw_query) const;
+
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentStatus status = DocumentStatus::ACTUAL,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentPredicate document_predicate,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy, const PreparedQuery& query, DocumentPredicate document_predicate,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy, const PreparedQuery& query, DocumentStatus status,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+
+    MatchDocumentType MatchDocument(const PreparedQuery& query, int document_id) const;
+
+    // Поиск с IDF, общим для нескольких серверов (как в ShardedSearchServer): запрос готовится
+    // на любом сервере с теми же стоп-словами, число документов с его словами суммируется
+    // по серверам, а каждый сервер отбирает лучшие документы с IDF, заданным снаружи.
+    // Число документов с каждым плюс-словом запроса, по порядку слов
+    std::vector<size_t> GetDocumentFreqs(const PreparedQuery& query) const;
+    static double ComputeWordInverseDocumentFreq(size_t document_count, size_t document_freq);
+    // inverse_document_freqs - по одному на плюс-слово, по порядку слов
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocumentsWithInverseDocumentFreqs(ExecutionPolicy policy, const PreparedQuery& query,
+                                                                   const std::vector<double>& inverse_document_freqs,
+                                                                   DocumentPredicate document_predicate,
+                                                                   size_t max_result_count = kMaxResultDocumentCount) const;
+
+    // Дубликаты по возрастанию id. Документы сравниваются по 128-битным отпечаткам наборов
+    // слов, совпадения отпечатков проверяются сравнением самих наборов
+    std::vector<int> FindDuplicates() const;
+    std::vector<int> FindDuplicates(const std::execution::sequenced_policy&) const;
+    std::vector<int> FindDuplicates(const std::execution::parallel_policy&) const;
+
+    // Пары документов с похожими наборами слов по возрастанию id. Кандидаты отбираются по
+    // полосам подписей MinHash (LSH), их сходство считается точно; пара с нужным сходством
+    // может не попасть в кандидаты с малой вероятностью, зависящей от числа и ширины полос
+    std::vector<NearDuplicate> FindNearDuplicates(const NearDuplicateOptions& options = {}) const;
+    std::vector<NearDuplicate> FindNearDuplicates(const std::execution::sequenced_policy&,
+                                                  const NearDuplicateOptions& options = {}) const;
+    std::vector<NearDuplicate> FindNearDuplicates(const std::execution::parallel_policy&,
+                                                  const NearDuplicateOptions& options = {}) const;
+
+    // Политика, отличная от ALLOW, строит индекс отпечатков документов и дальше ведёт его
+    // при добавлении и удалении
+    void SetDuplicatePolicy(DuplicatePolicy duplicate_policy);
+    DuplicatePolicy GetDuplicatePolicy() const;
+
     std::set<int>::iterator begin();
     std::set<int>::iterator end();
 
     void RemoveDocument(int document_id);
     void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
     void RemoveDocument(const std::execution::parallel_policy&, int document_id);
+
+    void RemoveDocuments(const std::vector<int>& document_ids);
+    void RemoveDocuments(const std::execution::sequenced_policy&, const std::vector<int>& document_ids);
+    void RemoveDocuments(const std::execution::parallel_policy&, const std::vector<int>& document_ids);
     
-   const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    // Ключи указывают на текст слов в словаре сервера и действительны, пока слово есть в индексе
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
+    // Идентификаторы термов документа по возрастанию
+    std::vector<TermId> GetDocumentTermIds(int document_id) const;
+
+    IndexStats GetIndexStats() const;
+    // Поддерживаемая индексом статистика слова; для отсутствующего слова - нули
+    TermStats GetTermStats(std::string_view word) const;
+
+    // Сохраняет индекс в двоичный снимок (см. index_snapshot.h)
+    void SaveSnapshot(const std::string& path) const;
+    // Открывает снимок через отображение в память: запросы обслуживаются прямо из файла,
+    // первое изменение индекса переносит его в память процесса. Открытие не читает данные
+    // индекса целиком; файлы из ненадёжного источника стоит открывать с verify_checksum
+    // или verify_structure (см. IndexSnapshot::Open)
+    static SearchServer OpenSnapshot(const std::string& path, bool verify_checksum = false, bool verify_structure = false);
+
+    // Подключает журнал изменений: каждое успешное AddDocument и RemoveDocument
+    // записывается в него до применения к индексу (nullptr отключает журнал)
+    void SetMutationLog(std::shared_ptr<MutationLog> mutation_log);
+    // Сохраняет снимок и очищает журнал: его изменения уже вошли в снимок.
+    // Журнал очищается только после того, как снимок сохранён на диске
+    void CompactMutationLog(const std::string& snapshot_path);
+
+    // Включает кэш результатов FindTopDocuments с фильтром по статусу или DocumentFilter (поиск с произвольным
+    // предикатом идёт мимо кэша). Копии сервера делят кэш: записи привязаны к поколению индекса
+    void EnableQueryCache(QueryCacheOptions options = {});
+    void DisableQueryCache();
+    QueryCacheStats GetQueryCacheStats() const;
+    // Поколение индекса меняется при каждом изменении документов; одинаковое поколение у
+    // копий сервера означает одинаковое содержимое
+    uint64_t GetGeneration() const;
+
+    void SetQueryEngine(QueryEngine query_engine);
+    QueryEngine GetQueryEngine() const;
 
 private:
-    struct DocumentData {
-        std::string data_string_;
-        int rating;
-        DocumentStatus status;
-    };
     std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
+    TermDictionary dictionary_;
+    // Списки вхождений по идентификатору терма
+    std::vector<PostingList> postings_;
+    // Статистика термов по идентификатору обновляется вместе с их списками вхождений;
+    // изменение числа документов меняет только log_document_count_, а IDF терма
+    // получается вычитанием логарифмов без пересчёта остальных термов
+    std::vector<TermBounds> term_bounds_;
+    double log_document_count_ = 0;
+    // Столбцы документов по порядковым номерам; у удалённых id == -1 до уплотнения
+    MappedVector<int> document_ids_;
+    MappedVector<int> ratings_;
+    MappedVector<DocumentStatus> statuses_;
+    // Документы каждого статуса по порядковым номерам; удалённые не входят ни в одну карту
+    // Списки длиннее этого после удаления не просматриваются ради точной max_term_freq:
+    // прежнее значение остаётся верхней границей и уточняется при уплотнении
+    static constexpr size_t kExactTermBoundsPostings = 16 * kPostingBlockSize;
+    std::array<OrdinalBitmap, kDocumentStatusCount> status_bitmaps_;
+    // Обратная длина документа: частота терма = число вхождений * inverse_word_counts_[ordinal]
+    MappedVector<double> inverse_word_counts_;
+    // Прямой индекс: термы документа по возрастанию id и число их вхождений
+    // лежат в [forward_offsets_[ordinal], forward_offsets_[ordinal + 1])
+    MappedVector<uint64_t> forward_offsets_;
+    MappedVector<TermId> forward_term_ids_;
+    MappedVector<uint32_t> forward_term_counts_;
+    std::unordered_map<int, DocumentOrdinal> document_ordinals_;
     std::set<int> doc_ids_set_;
-    std::map<int, std::map<std::string_view, double>> word_frequencies_;
+    // Открытый снимок: пока он задан, словарь, списки вхождений и поиск
+    // порядковых номеров читаются из него, а столбцы ссылаются на его память
+    std::shared_ptr<const IndexSnapshot> snapshot_;
+    std::shared_ptr<MutationLog> mutation_log_;
+    std::shared_ptr<QueryCache> query_cache_;
+    uint64_t generation_ = NextGeneration();
+    QueryEngine query_engine_ = QueryEngine::TERM_AT_A_TIME;
+    DuplicatePolicy duplicate_policy_ = DuplicatePolicy::ALLOW;
+    // При политике, отличной от ALLOW: id документов по отпечаткам их наборов слов и дубликаты
+    std::unordered_multimap<Fingerprint, int, FingerprintHasher> document_fingerprints_;
+    std::set<int> duplicate_ids_;
+
+    SearchServer() = default;
+
+    // Поколения выдаются из общего счётчика процесса, поэтому не повторяются у разных серверов
+    static uint64_t NextGeneration();
+
+    // Переносит открытый снимок в изменяемые структуры в памяти
+    void DetachSnapshot();
 
     static bool IsValidWord(std::string_view word);
 
     bool IsStopWord(std::string_view word) const;
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    // Слова text без стоп-слов в буфер words; false, если в тексте есть управляющие символы
+    bool SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    template <typename ExecutionPolicy>
+    void AddDocumentsImpl(ExecutionPolicy policy, const std::vector<NewDocument>& documents);
+
+    template <typename ExecutionPolicy>
+    void RemoveDocumentsImpl(ExecutionPolicy policy, std::vector<int> document_ids);
+
+    void CompactDocuments();
+
+    // Отпечатки по идентификаторам термов и по порядковым номерам документов (у удалённых - нулевые)
+    template <typename ExecutionPolicy>
+    std::vector<Fingerprint> ComputeTermFingerprints(ExecutionPolicy policy) const;
+    template <typename ExecutionPolicy>
+    std::vector<Fingerprint> ComputeDocumentFingerprints(ExecutionPolicy policy) const;
+    Fingerprint ComputeDocumentFingerprint(DocumentOrdinal ordinal) const;
+    bool HasSameTerms(DocumentOrdinal lhs, DocumentOrdinal rhs) const;
+    // unique_words - различные слова нового документа
+    bool HasSameTerms(DocumentOrdinal ordinal, const std::vector<std::string_view>& unique_words) const;
+    // Документ индекса с тем же набором слов или kNoOrdinal
+    DocumentOrdinal FindDuplicateOrdinal(const std::vector<std::string_view>& unique_words) const;
+    // Бросает invalid_argument при политике REJECT, если слова words повторяют набор слов документа индекса
+    void CheckNotDuplicate(const std::vector<std::string_view>& words) const;
+    // Учитывают документ в индексе отпечатков и в дубликатах
+    void RegisterFingerprint(DocumentOrdinal ordinal, const Fingerprint& fingerprint);
+    void UnregisterFingerprint(DocumentOrdinal ordinal);
+
+    template <typename ExecutionPolicy>
+    std::vector<int> FindDuplicatesImpl(ExecutionPolicy policy) const;
+    template <typename ExecutionPolicy>
+    std::vector<NearDuplicate> FindNearDuplicatesImpl(ExecutionPolicy policy, const NearDuplicateOptions& options) const;
+
+    // Отмечает статус документа в битовых картах; без статуса документ убирается из всех
+    void SetStatusBits(DocumentOrdinal ordinal, std::optional<DocumentStatus> status);
+    // Строит битовые карты заново по столбцам статусов и id
+    void RebuildStatusBitmaps();
+
+    size_t GetOrdinalCount() const;
+    DocumentOrdinal FindOrdinal(int document_id) const;
+    TermId FindTermId(std::string_view word) const;
+    std::string_view GetTerm(TermId term_id) const;
+    TermId GetTermIdBound() const;
+    PostingListView GetPostings(TermId term_id) const;
+    TermBounds GetTermBounds(TermId term_id) const;
+    double GetInverseDocumentFreq(TermId term_id) const;
+    // Выравнивает term_bounds_ и postings_ по границе идентификаторов словаря
+    void ReserveTermIds();
+
     struct QueryWord {
         std::string_view data;
         bool is_minus;
@@ -96,37 +368,171 @@ private:
 
     QueryWord ParseQueryWord(std::string_view& text) const;
 
+    // Запросы обычно короткие: их слова и списки вхождений помещаются во встроенные буферы
+    template <typename T>
+    using QueryBuffer = SmallVector<T, 8>;
+
     struct Query {
-        std::vector<std::string_view> plus_words;
-        std::vector<std::string_view> minus_words;
+        QueryBuffer<std::string_view> plus_words;
+        QueryBuffer<std::string_view> minus_words;
     };
 
     Query ParseQuery(std::string_view text) const;
 
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    bool HasTerm(DocumentOrdinal ordinal, std::string_view word) const;
+    MatchDocumentType MatchQuery(const Query& query, DocumentOrdinal ordinal) const;
+    bool HasTermId(DocumentOrdinal ordinal, TermId term_id) const;
+
+    struct PlusPostings {
+        PostingListView postings;
+        double inverse_document_freq;
+        // Верхняя граница вклада слова в релевантность документа
+        double max_score;
+    };
+
+    struct QueryPostings {
+        QueryBuffer<PlusPostings> plus;
+        QueryBuffer<PostingListView> minus;
+    };
+
+    QueryPostings FindQueryPostings(const Query& query) const;
+    // Для запроса, подготовленного на этом поколении индекса, термы уже найдены
+    QueryPostings FindQueryPostings(const PreparedQuery& query) const;
+    // IDF плюс-слов задан снаружи, по порядку слов запроса
+    QueryPostings FindQueryPostings(const PreparedQuery& query, const std::vector<double>& inverse_document_freqs) const;
+    // Терм слова подготовленного запроса: найденный при подготовке, если поколение то же
+    TermId FindPreparedTermId(const PreparedQuery& query, std::string_view word, TermId prepared_term_id) const;
+
+    // DocumentFilter, разрешённый в столбцы сервера: документ проверяется по порядковому номеру
+    struct OrdinalFilter {
+        // nullptr - подходит любой статус
+        const OrdinalBitmap* statuses = nullptr;
+        // nullptr - рейтинг не ограничен
+        const int* ratings = nullptr;
+        int min_rating = 0;
+        int max_rating = 0;
+
+        bool Accepts(DocumentOrdinal ordinal) const {
+            return (!statuses || statuses->Test(ordinal))
+                   && (!ratings || (ratings[ordinal] >= min_rating && ratings[ordinal] <= max_rating));
+        }
+    };
+
+    OrdinalFilter MakeOrdinalFilter(const DocumentFilter& filter) const;
 
+    // Фильтр по номеру проверяется до подсчёта релевантности, произвольный предикат - после
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    static bool PassesOrdinalFilter(const DocumentPredicate& document_predicate, DocumentOrdinal ordinal);
+    template <typename DocumentPredicate>
+    bool PassesDocumentPredicate(const DocumentPredicate& document_predicate, DocumentOrdinal ordinal) const;
+
+    static RelevanceAccumulator& GetThreadAccumulator();
+    // Буфер потока для кандидатов последовательного поиска
+    static std::vector<Document>& GetThreadDocuments();
+
+    // Курсоры обхода списков, переиспользуются запросами потока
+    struct QueryCursors {
+        std::vector<PostingCursor> plus;
+        std::vector<PostingCursor> minus;
+        // Номера плюс-курсоров по возрастанию текущего документа
+        std::vector<size_t> order;
+    };
+    static QueryCursors& GetThreadCursors();
+
+    // Учитывает запрос в QueryTrace, если трассировка включена; без visited_postings пройдены все вхождения
+    static void CountQueryPostings(const QueryPostings& query_postings, std::optional<size_t> visited_postings = std::nullopt);
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate) const;
+    void FindDocumentsInRange(const QueryPostings& query_postings, DocumentPredicate document_predicate,
+                              DocumentOrdinal first, DocumentOrdinal last, std::vector<Document>& matched_documents) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocumentsForQuery(ExecutionPolicy policy, const Query& query, DocumentPredicate document_predicate,
+                                                   size_t max_result_count) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocumentsForPostings(ExecutionPolicy policy, const QueryPostings& query_postings,
+                                                      DocumentPredicate document_predicate, size_t max_result_count) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsForPostings(ExecutionPolicy policy, const QueryPostings& query_postings,
+                                                      const DocumentFilter& filter, size_t max_result_count) const;
 
+    // Отбор WAND в диапазоне номеров: documents получает не более max_result_count лучших
+    // документов диапазона (неупорядоченно), возвращается число пройденных вхождений
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate) const;
+    size_t FindTopDocumentsInRange(const QueryPostings& query_postings, DocumentPredicate document_predicate,
+                                   DocumentOrdinal first, DocumentOrdinal last, size_t max_result_count,
+                                   std::vector<Document>& documents) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocumentsWand(ExecutionPolicy policy, const QueryPostings& query_postings,
+                                               DocumentPredicate document_predicate, size_t max_result_count) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(const QueryPostings& query_postings, DocumentPredicate document_predicate) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const QueryPostings& query_postings,
+                                           DocumentPredicate document_predicate) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const QueryPostings& query_postings,
+                                           DocumentPredicate document_predicate) const;
+};
+
+// Подготовленный запрос: слова разобраны один раз во встроенные буферы, термы найдены
+// в словаре, IDF посчитан. Разрешение действительно для поколения индекса, на котором
+// запрос подготовлен (и для копий сервера с тем же поколением); после изменения документов
+// запрос остаётся корректным, но термы ищутся заново при каждом выполнении.
+// Слова в результатах MatchDocument ссылаются на текст, которым владеет сам запрос.
+class SearchServer::PreparedQuery {
+public:
+    PreparedQuery() = default;
+
+    uint64_t GetGeneration() const;
+
+private:
+    friend class SearchServer;
+
+    std::shared_ptr<const std::string> text_;
+    Query query_;
+    // По порядку слов запроса; TermDictionary::kNoTerm - слова нет в индексе
+    QueryBuffer<TermId> plus_term_ids_;
+    QueryBuffer<double> inverse_document_freqs_;
+    QueryBuffer<TermId> minus_term_ids_;
+    uint64_t generation_ = 0;
 };
 
+using PreparedQuery = SearchServer::PreparedQuery;
+
 template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words) : stop_words_(MakeUniqueNonEmptyStrings(stop_words)){
     if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
         throw std::invalid_argument("Invalid symbols or word with minus-symbols only!");
     }
+    forward_offsets_.push_back(0);
 }
 
 template <typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-    });
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status,
+                                                     size_t max_result_count) const {
+    return FindTopDocuments(policy, raw_query, DocumentFilter{ status }, max_result_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, const DocumentFilter& filter,
+                                                     size_t max_result_count) const {
+    const SearchServer::Query query = SearchServer::ParseQuery(raw_query);
+    if (!query_cache_) {
+        return FindTopDocumentsForQuery(policy, query, filter, max_result_count);
+    }
+    const std::string key = QueryCache::MakeKey(query.plus_words, query.minus_words, filter, max_result_count);
+    std::vector<Document> documents;
+    if (!query_cache_->Find(key, generation_, documents)) {
+        documents = FindTopDocumentsForQuery(policy, query, filter, max_result_count);
+        query_cache_->Insert(key, generation_, documents);
+    }
+    return documents;
 }
 
 template <typename ExecutionPolicy>
@@ -135,103 +541,360 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+                                                     size_t max_result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_result_count);
 }
 
 template <typename ExecutionPolicy, typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
-    const SearchServer::Query query = SearchServer::ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
-    sort(policy, matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < kEpsilon) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
-        });
-    if (matched_documents.size() > kMaxResultDocumentCount) {
-        matched_documents.resize(kMaxResultDocumentCount);
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentPredicate document_predicate,
+                                                     size_t max_result_count) const {
+    return FindTopDocumentsForQuery(policy, SearchServer::ParseQuery(raw_query), document_predicate, max_result_count);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, DocumentPredicate document_predicate,
+                                                     size_t max_result_count) const {
+    return FindTopDocuments(std::execution::seq, query, document_predicate, max_result_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const PreparedQuery& query, DocumentStatus status,
+                                                     size_t max_result_count) const {
+    return FindTopDocuments(policy, query, DocumentFilter{ status }, max_result_count);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const PreparedQuery& query, DocumentPredicate document_predicate,
+                                                     size_t max_result_count) const {
+    return FindTopDocumentsForPostings(policy, FindQueryPostings(query), document_predicate, max_result_count);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocumentsWithInverseDocumentFreqs(ExecutionPolicy policy, const PreparedQuery& query,
+                                                                             const std::vector<double>& inverse_document_freqs,
+                                                                             DocumentPredicate document_predicate,
+                                                                             size_t max_result_count) const {
+    return FindTopDocumentsForPostings(policy, FindQueryPostings(query, inverse_document_freqs), document_predicate, max_result_count);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocumentsForQuery(ExecutionPolicy policy, const Query& query, DocumentPredicate document_predicate,
+                                                             size_t max_result_count) const {
+    return FindTopDocumentsForPostings(policy, FindQueryPostings(query), document_predicate, max_result_count);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocumentsForPostings(ExecutionPolicy policy, const QueryPostings& query_postings,
+                                                                DocumentPredicate document_predicate, size_t max_result_count) const {
+    if (query_engine_ == QueryEngine::WAND) {
+        return FindTopDocumentsWand(policy, query_postings, document_predicate, max_result_count);
     }
+    CountQueryPostings(query_postings);
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        auto matched_documents = FindAllDocuments(policy, query_postings, document_predicate);
+        SelectTopDocuments(policy, matched_documents, max_result_count);
         return matched_documents;
+    } else {
+        // Кандидаты набираются в буфер потока, память выделяется только под итоговый top-K
+        std::vector<Document>& matched_documents = GetThreadDocuments();
+        matched_documents.clear();
+        FindDocumentsInRange(query_postings, document_predicate, 0, GetOrdinalCount(), matched_documents);
+        SelectTopDocuments(std::execution::seq, matched_documents, max_result_count);
+        return { matched_documents.begin(), matched_documents.end() };
+    }
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsForPostings(ExecutionPolicy policy, const QueryPostings& query_postings,
+                                                                const DocumentFilter& filter, size_t max_result_count) const {
+    return FindTopDocumentsForPostings(policy, query_postings, MakeOrdinalFilter(filter), max_result_count);
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+bool SearchServer::PassesOrdinalFilter(const DocumentPredicate& document_predicate, DocumentOrdinal ordinal) {
+    if constexpr (std::is_same_v<DocumentPredicate, OrdinalFilter>) {
+        return document_predicate.Accepts(ordinal);
+    } else {
+        return true;
+    }
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-    for (std::string_view word : query.plus_words){
-        if (word_to_document_freqs_.count(word) == 0){
-            continue;
-        }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)){
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)){
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+bool SearchServer::PassesDocumentPredicate(const DocumentPredicate& document_predicate, DocumentOrdinal ordinal) const {
+    if constexpr (std::is_same_v<DocumentPredicate, OrdinalFilter>) {
+        return true;
+    } else {
+        return document_predicate(document_ids_[ordinal], statuses_[ordinal], ratings_[ordinal]);
+    }
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocumentsWand([[maybe_unused]] ExecutionPolicy policy, const QueryPostings& query_postings,
+                                                         DocumentPredicate document_predicate, size_t max_result_count) const {
+    const size_t ordinal_count = GetOrdinalCount();
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        // Диапазоны номеров отбираются независимо: лучшие документы всего индекса
+        // входят в лучшие документы своего диапазона
+        QueryExecutor& executor = QueryExecutor::GetCurrent();
+        const size_t chunk_count = std::min<size_t>(ordinal_count, 4 * executor.GetThreadCount());
+        if (chunk_count > 1) {
+            const size_t chunk_size = (ordinal_count + chunk_count - 1) / chunk_count;
+            const size_t actual_chunk_count = (ordinal_count + chunk_size - 1) / chunk_size;
+            std::vector<std::vector<Document>> chunk_documents(actual_chunk_count);
+            std::vector<size_t> chunk_visited_postings(actual_chunk_count);
+            executor.ParallelFor(actual_chunk_count, 1,
+                    [&](size_t chunk) {
+                        const size_t first = chunk * chunk_size;
+                        const size_t last = std::min(first + chunk_size, ordinal_count);
+                        chunk_visited_postings[chunk] = FindTopDocumentsInRange(
+                                query_postings, document_predicate, first, last, max_result_count, chunk_documents[chunk]);
+                    }
+            );
+            std::vector<Document> top_documents;
+            for (const auto& documents : chunk_documents) {
+                top_documents.insert(top_documents.end(), documents.begin(), documents.end());
             }
+            SelectTopDocuments(std::execution::seq, top_documents, max_result_count);
+            CountQueryPostings(query_postings,
+                               std::accumulate(chunk_visited_postings.begin(), chunk_visited_postings.end(), size_t(0)));
+            return top_documents;
         }
     }
+    std::vector<Document>& top_documents = GetThreadDocuments();
+    top_documents.clear();
+    CountQueryPostings(query_postings,
+                       FindTopDocumentsInRange(query_postings, document_predicate, 0, ordinal_count, max_result_count, top_documents));
+    SelectTopDocuments(std::execution::seq, top_documents, max_result_count);
+    return { top_documents.begin(), top_documents.end() };
+}
 
-    for (std::string_view word : query.minus_words){
-        if (word_to_document_freqs_.count(word) == 0){
+template <typename DocumentPredicate>
+size_t SearchServer::FindTopDocumentsInRange(const QueryPostings& query_postings, DocumentPredicate document_predicate,
+                                             DocumentOrdinal first, DocumentOrdinal last, size_t max_result_count,
+                                             std::vector<Document>& documents) const {
+    if (max_result_count == 0) {
+        return 0;
+    }
+    // У WAND стадии перемежаются, поэтому весь обход учитывается как стадия postings
+    QueryStageTimer timer(QueryStage::POSTINGS);
+    uint64_t candidates = 0;
+    uint64_t matched = 0;
+    QueryCursors& cursors = GetThreadCursors();
+    cursors.plus.clear();
+    cursors.minus.clear();
+    cursors.order.clear();
+    for (const PlusPostings& plus : query_postings.plus) {
+        cursors.order.push_back(cursors.plus.size());
+        cursors.plus.emplace_back(plus.postings);
+        cursors.plus.back().Advance(first);
+    }
+    for (const PostingListView& postings : query_postings.minus) {
+        cursors.minus.emplace_back(postings);
+    }
+    const auto current_ordinal = [&cursors](size_t index) {
+        return cursors.plus[index].GetOrdinal();
+    };
+
+    // Наименьшая релевантность среди набранных документов: пока их меньше max_result_count,
+    // оценивается каждый документ. Документ с верхней границей ниже порога больше чем на
+    // kEpsilon уступает по релевантности всем набранным, поэтому не может попасть в top-K
+    double threshold = -std::numeric_limits<double>::infinity();
+    while (true) {
+        // Слов в запросе единицы, поэтому курсоры упорядочиваются вставками
+        for (size_t i = 1; i < cursors.order.size(); ++i) {
+            for (size_t j = i; j > 0 && current_ordinal(cursors.order[j]) < current_ordinal(cursors.order[j - 1]); --j) {
+                std::swap(cursors.order[j], cursors.order[j - 1]);
+            }
+        }
+        // Опорный курсор - первый, на котором сумма верхних границ достигает порога
+        double upper_bound = 0;
+        size_t pivot = 0;
+        for (; pivot < cursors.order.size(); ++pivot) {
+            upper_bound += query_postings.plus[cursors.order[pivot]].max_score;
+            if (upper_bound + kEpsilon >= threshold) {
+                break;
+            }
+        }
+        if (pivot == cursors.order.size()) {
+            break;
+        }
+        const DocumentOrdinal ordinal = current_ordinal(cursors.order[pivot]);
+        if (ordinal >= last) {
+            break;
+        }
+        if (current_ordinal(cursors.order.front()) != ordinal) {
+            // Документы до опорного содержат только слова с недостаточной суммой границ
+            for (size_t i = 0; i < pivot; ++i) {
+                cursors.plus[cursors.order[i]].Advance(ordinal);
+            }
             continue;
         }
-        for (const auto [document_id, sec] : word_to_document_freqs_.at(word)){
-            document_to_relevance.erase(document_id);
-            (void)sec;
+
+        bool is_excluded = false;
+        for (PostingCursor& cursor : cursors.minus) {
+            cursor.Advance(ordinal);
+            is_excluded = is_excluded || cursor.GetOrdinal() == ordinal;
+        }
+        if (!is_excluded && PassesOrdinalFilter(document_predicate, ordinal)) {
+            // Слагаемые в порядке слов запроса, как в FindDocumentsInRange: релевантность совпадает до бита
+            double relevance = 0;
+            for (size_t index = 0; index < cursors.plus.size(); ++index) {
+                if (cursors.plus[index].GetOrdinal() == ordinal) {
+                    relevance += cursors.plus[index].GetCount() * inverse_word_counts_[ordinal] * query_postings.plus[index].inverse_document_freq;
+                }
+            }
+            ++candidates;
+            if (PassesDocumentPredicate(document_predicate, ordinal)) {
+                ++matched;
+                const Document document{ document_ids_[ordinal], relevance, ratings_[ordinal] };
+                // Куча с наименее релевантным документом в вершине
+                bool is_added = false;
+                if (documents.size() < max_result_count) {
+                    documents.push_back(document);
+                    std::push_heap(documents.begin(), documents.end(), IsMoreRelevant);
+                    is_added = true;
+                } else if (IsMoreRelevant(document, documents.front())) {
+                    std::pop_heap(documents.begin(), documents.end(), IsMoreRelevant);
+                    documents.back() = document;
+                    std::push_heap(documents.begin(), documents.end(), IsMoreRelevant);
+                    is_added = true;
+                }
+                if (is_added && documents.size() == max_result_count) {
+                    threshold = std::min_element(documents.begin(), documents.end(),
+                                                 [](const Document& lhs, const Document& rhs) {
+                                                     return lhs.relevance < rhs.relevance;
+                                                 })->relevance;
+                }
+            }
+        }
+        for (PostingCursor& cursor : cursors.plus) {
+            if (cursor.GetOrdinal() == ordinal) {
+                cursor.Next();
+            }
         }
     }
 
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance){
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    size_t visited_postings = 0;
+    for (const PostingCursor& cursor : cursors.plus) {
+        visited_postings += cursor.GetVisitedCount();
     }
-    return matched_documents;
+    QueryTrace::CountDocuments(candidates, matched);
+    return visited_postings;
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(101);
+std::vector<Document> SearchServer::FindAllDocuments(const QueryPostings& query_postings, DocumentPredicate document_predicate) const {
+    return FindAllDocuments(std::execution::seq, query_postings, document_predicate);
+}
 
-    for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(),
-            [this, &document_predicate, &document_to_relevance] (std::string_view word) {
-                 if (word_to_document_freqs_.count(word) == 0) {
-                    return;
-                }
-                const double document_freq = ComputeWordInverseDocumentFreq(word);
-                for (const auto& [document_id, freq] : word_to_document_freqs_.at(word)) {
-                    const auto& document_data = documents_.at(document_id);
-                    if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                        document_to_relevance[document_id].value_reference += freq * document_freq;
-                    }
-                }
+template <typename DocumentPredicate>
+void SearchServer::FindDocumentsInRange(const QueryPostings& query_postings, DocumentPredicate document_predicate,
+                                        DocumentOrdinal first, DocumentOrdinal last, std::vector<Document>& matched_documents) const {
+    RelevanceAccumulator& accumulator = GetThreadAccumulator();
+    accumulator.Reset(GetOrdinalCount());
+
+    // Минус-слова разрешаются до подсчёта релевантности, и исключённые документы не оцениваются.
+    // Обычно список минус-слова сразу помечает свои документы в аккумуляторе. Если же в нём
+    // больше блоков, чем вхождений у всех плюс-слов, вхождения проверяются курсором: он
+    // распаковывает не больше блока на вхождение и перескакивает остальные
+    size_t plus_size = 0;
+    for (const PlusPostings& plus : query_postings.plus){
+        plus_size += plus.postings.Size();
+    }
+    QueryCursors& cursors = GetThreadCursors();
+    cursors.minus.clear();
+    {
+        QueryStageTimer timer(QueryStage::MINUS_WORDS);
+        for (const PostingListView& postings : query_postings.minus){
+            if (postings.Size() / kPostingBlockSize > plus_size){
+                cursors.minus.emplace_back(postings);
+                continue;
             }
-    );
+            postings.ForEach(first, last, [&accumulator](DocumentOrdinal ordinal, uint32_t) {
+                accumulator.Exclude(ordinal);
+            });
+        }
+    }
 
-    for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
-            [&](std::string_view word) {
-                if (word_to_document_freqs_.count(word) == 0) {
-                    return;
+    QueryStageTimer postings_timer(QueryStage::POSTINGS);
+    for (const PlusPostings& plus : query_postings.plus){
+        const double idf = plus.inverse_document_freq;
+        if (cursors.minus.empty()){
+            plus.postings.ForEach(first, last, [this, &accumulator, &document_predicate, idf](DocumentOrdinal ordinal, uint32_t count) {
+                if (PassesOrdinalFilter(document_predicate, ordinal)){
+                    accumulator.Add(ordinal, count * inverse_word_counts_[ordinal] * idf);
                 }
-                for (const auto& [document_id, sec] : word_to_document_freqs_.at(word)) {
-                    document_to_relevance.Erase(document_id);
-                    (void)sec;
+            });
+            continue;
+        }
+        // Каждое плюс-слово проходит свои номера по возрастанию, поэтому курсоры начинают заново
+        for (PostingCursor& cursor : cursors.minus){
+            cursor = PostingCursor(cursor.GetPostings());
+        }
+        plus.postings.ForEach(first, last, [this, &accumulator, &cursors, &document_predicate, idf](DocumentOrdinal ordinal, uint32_t count) {
+            if (!PassesOrdinalFilter(document_predicate, ordinal)){
+                return;
+            }
+            for (PostingCursor& cursor : cursors.minus){
+                cursor.Advance(ordinal);
+                if (cursor.GetOrdinal() == ordinal){
+                    return;
                 }
             }
-    );
+            accumulator.Add(ordinal, count * inverse_word_counts_[ordinal] * idf);
+        });
+    }
+
+    postings_timer.Stop();
 
-    const auto& document_to_relevance_builded = document_to_relevance.BuildMap();
+    QueryStageTimer collect_timer(QueryStage::COLLECT);
+    uint64_t candidates = 0;
+    const size_t matched_count = matched_documents.size();
+    for (const DocumentOrdinal ordinal : accumulator.GetTouched()){
+        if (!accumulator.IsMatched(ordinal)){
+            continue;
+        }
+        ++candidates;
+        if (PassesDocumentPredicate(document_predicate, ordinal)){
+            matched_documents.push_back({ document_ids_[ordinal], accumulator.GetRelevance(ordinal), ratings_[ordinal] });
+        }
+    }
+    QueryTrace::CountDocuments(candidates, matched_documents.size() - matched_count);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, const QueryPostings& query_postings,
+                                                     DocumentPredicate document_predicate) const {
+    std::vector<Document> matched_documents;
+    FindDocumentsInRange(query_postings, document_predicate, 0, GetOrdinalCount(), matched_documents);
+    return matched_documents;
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const QueryPostings& query_postings,
+                                                     DocumentPredicate document_predicate) const {
+    // Пространство порядковых номеров делится на непересекающиеся диапазоны:
+    // каждая задача набирает релевантность в собственный аккумулятор без блокировок
+    const size_t ordinal_count = GetOrdinalCount();
+    QueryExecutor& executor = QueryExecutor::GetCurrent();
+    const size_t chunk_count = std::min<size_t>(ordinal_count, 4 * executor.GetThreadCount());
+    if (chunk_count <= 1) {
+        return FindAllDocuments(std::execution::seq, query_postings, document_predicate);
+    }
+    const size_t chunk_size = (ordinal_count + chunk_count - 1) / chunk_count;
+    std::vector<std::vector<Document>> chunk_documents((ordinal_count + chunk_size - 1) / chunk_size);
+    executor.ParallelFor(chunk_documents.size(), 1,
+            [&](size_t chunk) {
+                const size_t first = chunk * chunk_size;
+                const size_t last = std::min(first + chunk_size, ordinal_count);
+                FindDocumentsInRange(query_postings, document_predicate, first, last, chunk_documents[chunk]);
+            }
+    );
 
     std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance_builded){
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    for (const auto& documents : chunk_documents){
+        matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
     }
     return matched_documents;
 }
@@ -0,0 +1,107 @@
+#include "sharded_search_server.h"
+
+#include <cstdint>
+#include <numeric>
+
+using namespace std;
+
+    ShardedSearchServer::ShardedSearchServer(const string& stop_words_text, size_t shard_count)
+        : ShardedSearchServer(SplitIntoWords(stop_words_text), shard_count) {
+    }
+
+    void ShardedSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+        shards_[GetShardIndex(document_id)].AddDocument(document_id, document, status, ratings);
+    }
+
+    void ShardedSearchServer::AddDocuments(const vector<NewDocument>& documents) {
+        vector<vector<NewDocument>> shard_documents(shards_.size());
+        for (const NewDocument& document : documents) {
+            shard_documents[GetShardIndex(document.id)].push_back(document);
+        }
+        // Один id всегда попадает в один сегмент, поэтому проверок сегментов достаточно для всей пачки
+        for (size_t index = 0; index < shards_.size(); ++index) {
+            shards_[index].ValidateNewDocuments(execution::par, shard_documents[index]);
+        }
+        vector<size_t> shard_indexes(shards_.size());
+        iota(shard_indexes.begin(), shard_indexes.end(), 0);
+        for_each(execution::par, shard_indexes.begin(), shard_indexes.end(),
+                 [this, &shard_documents](size_t index) {
+                     shards_[index].AddDocuments(execution::par, shard_documents[index]);
+                 });
+    }
+
+    void ShardedSearchServer::RemoveDocument(int document_id) {
+        shards_[GetShardIndex(document_id)].RemoveDocument(document_id);
+    }
+
+    void ShardedSearchServer::RemoveDocuments(const vector<int>& document_ids) {
+        vector<vector<int>> shard_ids(shards_.size());
+        for (const int document_id : document_ids) {
+            shard_ids[GetShardIndex(document_id)].push_back(document_id);
+        }
+        for (size_t index = 0; index < shards_.size(); ++index) {
+            shards_[index].RemoveDocuments(shard_ids[index]);
+        }
+    }
+
+    vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query) const {
+        return FindTopDocuments(execution::seq, raw_query, DocumentStatus::ACTUAL);
+    }
+
+    vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_result_count) const {
+        return FindTopDocuments(execution::seq, raw_query, status, max_result_count);
+    }
+
+    int ShardedSearchServer::GetDocumentCount() const {
+        int document_count = 0;
+        for (const SearchServer& shard : shards_) {
+            document_count += shard.GetDocumentCount();
+        }
+        return document_count;
+    }
+
+    MatchDocumentType ShardedSearchServer::MatchDocument(string_view raw_query, int document_id) const {
+        return shards_[GetShardIndex(document_id)].MatchDocument(raw_query, document_id);
+    }
+
+    map<string_view, double> ShardedSearchServer::GetWordFrequencies(int document_id) const {
+        return shards_[GetShardIndex(document_id)].GetWordFrequencies(document_id);
+    }
+
+    void ShardedSearchServer::SetQueryEngine(QueryEngine query_engine) {
+        for (SearchServer& shard : shards_) {
+            shard.SetQueryEngine(query_engine);
+        }
+    }
+
+    size_t ShardedSearchServer::GetShardCount() const {
+        return shards_.size();
+    }
+
+    size_t ShardedSearchServer::GetShardIndex(int document_id) const {
+        // Перемешивание Фибоначчи: соседние id расходятся по разным сегментам
+        const uint64_t hash = static_cast<uint32_t>(document_id) * 0x9E3779B97F4A7C15ull;
+        return (hash >> 32) % shards_.size();
+    }
+
+    const SearchServer& ShardedSearchServer::GetShard(size_t index) const {
+        return shards_.at(index);
+    }
+
+    vector<double> ShardedSearchServer::ComputeInverseDocumentFreqs(const PreparedQuery& query) const {
+        size_t document_count = 0;
+        vector<size_t> document_freqs;
+        for (const SearchServer& shard : shards_) {
+            document_count += shard.GetDocumentCount();
+            const vector<size_t> shard_document_freqs = shard.GetDocumentFreqs(query);
+            document_freqs.resize(shard_document_freqs.size());
+            for (size_t index = 0; index < shard_document_freqs.size(); ++index) {
+                document_freqs[index] += shard_document_freqs[index];
+            }
+        }
+        vector<double> inverse_document_freqs(document_freqs.size());
+        for (size_t index = 0; index < document_freqs.size(); ++index) {
+            inverse_document_freqs[index] = SearchServer::ComputeWordInverseDocumentFreq(document_count, document_freqs[index]);
+        }
+        return inverse_document_freqs;
+    }
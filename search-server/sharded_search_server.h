@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <execution>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "query_executor.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+// Поисковый сервер, разбитый на сегменты: документы распределяются между несколькими
+// SearchServer по хешу id, запрос выполняется во всех сегментах (с политикой par -
+// параллельно), а лучшие документы сегментов сливаются. IDF считается по всему корпусу:
+// перед поиском число документов и число документов с каждым словом суммируются по
+// сегментам, поэтому релевантность та же, что у одного SearchServer с этими документами.
+class ShardedSearchServer {
+public:
+    template <typename StringContainer>
+    ShardedSearchServer(const StringContainer& stop_words, size_t shard_count);
+    ShardedSearchServer(const std::string& stop_words_text, size_t shard_count);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    // Пачка проверяется во всех сегментах до изменения любого из них, затем сегменты пополняются параллельно
+    void AddDocuments(const std::vector<NewDocument>& documents);
+
+    void RemoveDocument(int document_id);
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    // Предикатом может быть и DocumentFilter: сегменты проверят его по своим битовым картам статусов
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentPredicate document_predicate,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status,
+                                           size_t max_result_count = kMaxResultDocumentCount) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const;
+
+    int GetDocumentCount() const;
+
+    MatchDocumentType MatchDocument(std::string_view raw_query, int document_id) const;
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
+
+    // Способ обхода списков вхождений во всех сегментах
+    void SetQueryEngine(QueryEngine query_engine);
+
+    size_t GetShardCount() const;
+    size_t GetShardIndex(int document_id) const;
+    const SearchServer& GetShard(size_t index) const;
+
+private:
+    std::vector<SearchServer> shards_;
+
+    // IDF плюс-слов запроса по всем сегментам
+    std::vector<double> ComputeInverseDocumentFreqs(const PreparedQuery& query) const;
+};
+
+template <typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(const StringContainer& stop_words, size_t shard_count) {
+    if (shard_count == 0) {
+        throw std::invalid_argument("Shard count must be positive");
+    }
+    // Каждый сегмент строится отдельно, а не копируется с образца: у копий оказался бы общий кэш запросов
+    shards_.reserve(shard_count);
+    for (size_t index = 0; index < shard_count; ++index) {
+        shards_.emplace_back(stop_words);
+    }
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+                                                            size_t max_result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_result_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status,
+                                                            size_t max_result_count) const {
+    return FindTopDocuments(policy, raw_query, DocumentFilter{ status }, max_result_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments([[maybe_unused]] ExecutionPolicy policy, std::string_view raw_query,
+                                                            DocumentPredicate document_predicate, size_t max_result_count) const {
+    // Стоп-слова у сегментов общие, поэтому запрос разбирается один раз
+    const PreparedQuery query = shards_.front().PrepareQuery(raw_query);
+    const std::vector<double> inverse_document_freqs = ComputeInverseDocumentFreqs(query);
+
+    // Каждый сегмент сразу отбирает свои лучшие документы: в общий результат попадут только они
+    std::vector<std::vector<Document>> shard_documents(shards_.size());
+    const auto find_in_shard = [&](size_t index) {
+        shard_documents[index] = shards_[index].FindTopDocumentsWithInverseDocumentFreqs(
+                std::execution::seq, query, inverse_document_freqs, document_predicate, max_result_count);
+    };
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        QueryExecutor::GetCurrent().ParallelFor(shards_.size(), 1, find_in_shard);
+    } else {
+        for (size_t index = 0; index < shards_.size(); ++index) {
+            find_in_shard(index);
+        }
+    }
+
+    std::vector<Document> matched_documents;
+    for (const auto& documents : shard_documents) {
+        matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+    }
+    SelectTopDocuments(matched_documents, max_result_count);
+    return matched_documents;
+}
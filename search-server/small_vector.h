@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Массив с встроенным буфером на N элементов: пока элементов не больше N, память
+// не выделяется. При переполнении элементы переносятся в std::vector; clear()
+// возвращает массив во встроенный буфер, но сохраняет ёмкость вектора для следующего раза.
+template <typename T, size_t N>
+class SmallVector {
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    size_t size() const {
+        return on_heap_ ? heap_.size() : size_;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    T* data() {
+        return on_heap_ ? heap_.data() : inline_.data();
+    }
+
+    const T* data() const {
+        return on_heap_ ? heap_.data() : inline_.data();
+    }
+
+    T* begin() {
+        return data();
+    }
+
+    T* end() {
+        return data() + size();
+    }
+
+    const T* begin() const {
+        return data();
+    }
+
+    const T* end() const {
+        return data() + size();
+    }
+
+    T& operator[](size_t index) {
+        return data()[index];
+    }
+
+    const T& operator[](size_t index) const {
+        return data()[index];
+    }
+
+    const T& back() const {
+        return data()[size() - 1];
+    }
+
+    void push_back(const T& value) {
+        if (on_heap_) {
+            heap_.push_back(value);
+        } else if (size_ < N) {
+            inline_[size_++] = value;
+        } else {
+            heap_.assign(inline_.begin(), inline_.end());
+            heap_.push_back(value);
+            on_heap_ = true;
+        }
+    }
+
+    template <typename... Args>
+    void emplace_back(Args&&... args) {
+        push_back(T(std::forward<Args>(args)...));
+    }
+
+    T* erase(T* first, T* last) {
+        const size_t new_size = size() - (last - first);
+        std::move(last, end(), first);
+        if (on_heap_) {
+            heap_.erase(heap_.begin() + new_size, heap_.end());
+        } else {
+            size_ = new_size;
+        }
+        return first;
+    }
+
+    void clear() {
+        heap_.clear();
+        on_heap_ = false;
+        size_ = 0;
+    }
+
+private:
+    std::array<T, N> inline_{};
+    size_t size_ = 0;
+    std::vector<T> heap_;
+    bool on_heap_ = false;
+};
@@ -1,25 +1,124 @@
 #include "string_processing.h"
 
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
+namespace {
+
+const size_t kBlockSize = 64;
+
+// Маски блока из 64 байт: бит i - байт i является пробелом / управляющим символом
+struct BlockMasks {
+    uint64_t spaces;
+    uint64_t controls;
+};
+
+BlockMasks ClassifyBlock(const char* data) {
+#if defined(__AVX2__)
+    const __m256i space = _mm256_set1_epi8(' ');
+    // Управляющие символы - ровно те байты, у которых три старших бита нулевые
+    const __m256i high_bits = _mm256_set1_epi8(static_cast<char>(0xE0));
+    const __m256i zero = _mm256_setzero_si256();
+    BlockMasks masks{ 0, 0 };
+    for (size_t half = 0; half < 2; ++half) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + half * 32));
+        const uint32_t spaces = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, space));
+        const uint32_t controls = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(bytes, high_bits), zero));
+        masks.spaces |= static_cast<uint64_t>(spaces) << (half * 32);
+        masks.controls |= static_cast<uint64_t>(controls) << (half * 32);
+    }
+    return masks;
+#elif defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i high_bits = _mm_set1_epi8(static_cast<char>(0xE0));
+    const __m128i zero = _mm_setzero_si128();
+    BlockMasks masks{ 0, 0 };
+    for (size_t quarter = 0; quarter < 4; ++quarter) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + quarter * 16));
+        const uint32_t spaces = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, space));
+        const uint32_t controls = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(bytes, high_bits), zero));
+        masks.spaces |= static_cast<uint64_t>(spaces) << (quarter * 16);
+        masks.controls |= static_cast<uint64_t>(controls) << (quarter * 16);
+    }
+    return masks;
+#else
+    BlockMasks masks{ 0, 0 };
+    for (size_t i = 0; i < kBlockSize; ++i) {
+        const unsigned char c = data[i];
+        masks.spaces |= static_cast<uint64_t>(c == ' ') << i;
+        masks.controls |= static_cast<uint64_t>(c < ' ') << i;
+    }
+    return masks;
+#endif
+}
+
+// Классифицирует блок, начинающийся с offset; неполный последний блок дополняется пробелами
+BlockMasks ClassifyBlockAt(string_view text, size_t offset) {
+    if (text.size() - offset >= kBlockSize) {
+        return ClassifyBlock(text.data() + offset);
+    }
+    char tail[kBlockSize];
+    memset(tail, ' ', kBlockSize);
+    memcpy(tail, text.data() + offset, text.size() - offset);
+    return ClassifyBlock(tail);
+}
+
+}  // namespace
+
 vector<string_view> SplitIntoWords(string_view text){
     vector<string_view> words;
-    string_view word;
-	string_view temp;
-
-    uint64_t start = text.find_first_not_of(" ");
-    const uint64_t end = text.npos;
+    SplitIntoWords(text, words);
+    return words;
+}
 
-    while (start != end) {
-        uint64_t delimiter = text.find(' ', start);
-        if(delimiter == end){
-        	temp = text.substr(start);
+bool SplitIntoWords(string_view text, vector<string_view>& words){
+    words.clear();
+    uint64_t controls = 0;
+    bool in_word = false;
+    size_t word_start = 0;
+    for (size_t offset = 0; offset < text.size(); offset += kBlockSize) {
+        const BlockMasks masks = ClassifyBlockAt(text, offset);
+        controls |= masks.controls;
+        // Начала и концы слов - позиции, где признак «не пробел» отличается от предыдущего байта.
+        // Они чередуются, поэтому слова блока собираются парами без ветвления на каждой границе
+        const uint64_t word_bytes = ~masks.spaces;
+        const uint64_t previous = (word_bytes << 1) | static_cast<uint64_t>(in_word);
+        uint64_t starts = word_bytes & ~previous;
+        uint64_t ends = ~word_bytes & previous;
+        if (in_word && ends != 0) {
+            words.push_back(text.substr(word_start, offset + __builtin_ctzll(ends) - word_start));
+            ends &= ends - 1;
         }
-        else{
-        	temp = text.substr(start, delimiter - start);
+        while (starts != 0) {
+            const size_t start = offset + __builtin_ctzll(starts);
+            starts &= starts - 1;
+            if (ends == 0) {
+                word_start = start;
+                break;
+            }
+            words.push_back(text.substr(start, offset + __builtin_ctzll(ends) - start));
+            ends &= ends - 1;
         }
-        words.push_back(temp);
-        start = text.find_first_not_of(" ", delimiter);
+        in_word = (word_bytes >> (kBlockSize - 1)) != 0;
     }
-    return words;
+    // Слово, дошедшее до конца текста длиной кратной блоку, не закрыто пробелом дополнения
+    if (in_word) {
+        words.push_back(text.substr(word_start));
+    }
+    return controls == 0;
+}
+
+bool HasNoControlCharacters(string_view text){
+    for (size_t offset = 0; offset < text.size(); offset += kBlockSize) {
+        if (ClassifyBlockAt(text, offset).controls != 0) {
+            return false;
+        }
+    }
+    return true;
 }
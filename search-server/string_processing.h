@@ -1,10 +1,20 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
 #include <set>
 
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+// Разбивает text на слова по пробелам в буфер words (прежнее содержимое стирается) и за тот
+// же проход ищет управляющие символы (коды 0-31). Возвращает false, если они встретились;
+// слова при этом всё равно разбираются полностью. Блоки по 64 байта классифицируются
+// AVX2 или SSE2, если компилятор их поддерживает, иначе побайтно
+bool SplitIntoWords(std::string_view text, std::vector<std::string_view>& words);
+
+// true, если в text нет управляющих символов
+bool HasNoControlCharacters(std::string_view text);
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings){
     std::set<std::string, std::less<>> non_empty_strings;
@@ -0,0 +1,115 @@
+#include "term_dictionary.h"
+
+#include <cstring>
+
+using namespace std;
+
+TermDictionary::TermDictionary(const TermDictionary& other) {
+    *this = other;
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+    if (this != &other) {
+        Assign(other.terms_);
+        free_ids_ = other.free_ids_;
+    }
+    return *this;
+}
+
+TermId TermDictionary::Find(string_view term) const {
+    const auto it = ids_.find(term);
+    return it == ids_.end() ? kNoTerm : it->second;
+}
+
+TermId TermDictionary::Intern(string_view term) {
+    const auto it = ids_.find(term);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    string_view stored;
+    const auto free_text = free_text_.find(term.size());
+    if (free_text != free_text_.end() && !free_text->second.empty()) {
+        char* data = free_text->second.back();
+        free_text->second.pop_back();
+        memcpy(data, term.data(), term.size());
+        stored = string_view(data, term.size());
+        released_text_bytes_ -= term.size();
+    } else {
+        stored = arena_.Store(term);
+    }
+    live_text_bytes_ += stored.size();
+    TermId id;
+    if (free_ids_.empty()) {
+        id = terms_.size();
+        terms_.push_back(stored);
+    } else {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+        terms_[id] = stored;
+    }
+    ids_.emplace(stored, id);
+    return id;
+}
+
+void TermDictionary::Release(TermId id) {
+    const string_view term = terms_[id];
+    ids_.erase(term);
+    live_text_bytes_ -= term.size();
+    released_text_bytes_ += term.size();
+    // Текст лежит в собственной арене словаря, поэтому его место можно переписать
+    free_text_[term.size()].push_back(const_cast<char*>(term.data()));
+    terms_[id] = {};
+    free_ids_.push_back(id);
+}
+
+void TermDictionary::Assign(const vector<string_view>& terms) {
+    arena_ = TextArena();
+    ids_.clear();
+    terms_.clear();
+    free_ids_.clear();
+    free_text_.clear();
+    live_text_bytes_ = 0;
+    released_text_bytes_ = 0;
+    ids_.reserve(terms.size());
+    terms_.reserve(terms.size());
+    for (TermId id = 0; id < terms.size(); ++id) {
+        if (terms[id].empty()) {
+            terms_.emplace_back();
+            free_ids_.push_back(id);
+        } else {
+            terms_.push_back(arena_.Store(terms[id]));
+            ids_.emplace(terms_.back(), id);
+            live_text_bytes_ += terms[id].size();
+        }
+    }
+}
+
+string_view TermDictionary::GetTerm(TermId id) const {
+    return terms_[id];
+}
+
+size_t TermDictionary::Size() const {
+    return ids_.size();
+}
+
+TermId TermDictionary::GetIdBound() const {
+    return terms_.size();
+}
+
+size_t TermDictionary::GetMemoryUsage() const {
+    size_t free_text_usage = free_text_.bucket_count() * sizeof(void*);
+    for (const auto& [size, places] : free_text_) {
+        free_text_usage += sizeof(size) + sizeof(places) + 2 * sizeof(void*) + places.capacity() * sizeof(char*);
+    }
+    return arena_.GetMemoryUsage() + ids_.bucket_count() * sizeof(void*)
+           + ids_.size() * (sizeof(string_view) + sizeof(TermId) + 2 * sizeof(void*))
+           + terms_.capacity() * sizeof(string_view) + free_ids_.capacity() * sizeof(TermId) + free_text_usage;
+}
+
+size_t TermDictionary::GetLiveTextBytes() const {
+    return live_text_bytes_;
+}
+
+size_t TermDictionary::GetReleasedTextBytes() const {
+    return released_text_bytes_;
+}
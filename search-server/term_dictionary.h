@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "text_arena.h"
+
+using TermId = uint32_t;
+
+// Словарь термов: каждому различному слову выдаётся 32-битный идентификатор,
+// текст слова хранится в арене в единственном экземпляре.
+class TermDictionary {
+public:
+    static const TermId kNoTerm = std::numeric_limits<TermId>::max();
+
+    TermDictionary() = default;
+    // Копия получает собственную арену с теми же идентификаторами и тем же порядком свободных
+    TermDictionary(const TermDictionary& other);
+    TermDictionary& operator=(const TermDictionary& other);
+    TermDictionary(TermDictionary&&) = default;
+    TermDictionary& operator=(TermDictionary&&) = default;
+
+    TermId Find(std::string_view term) const;
+    TermId Intern(std::string_view term);
+    // Освобождённый идентификатор будет выдан повторно, а место текста слова займёт
+    // следующее новое слово той же длины. Тексты живых термов никогда не перемещаются
+    void Release(TermId id);
+    // Заменяет содержимое словаря: terms[id] - текст терма, пустая строка - свободный идентификатор
+    void Assign(const std::vector<std::string_view>& terms);
+
+    std::string_view GetTerm(TermId id) const;
+    size_t Size() const;
+    // Все выданные идентификаторы меньше этого значения
+    TermId GetIdBound() const;
+
+    size_t GetMemoryUsage() const;
+    // Байты арены, занятые текстом живых термов и свободные после освобождённых
+    size_t GetLiveTextBytes() const;
+    size_t GetReleasedTextBytes() const;
+
+private:
+    TextArena arena_;
+    std::unordered_map<std::string_view, TermId> ids_;
+    std::vector<std::string_view> terms_;
+    std::vector<TermId> free_ids_;
+    // Места текстов освобождённых термов по длине; арена растёт, только если места нужной длины нет
+    std::unordered_map<size_t, std::vector<char*>> free_text_;
+    size_t live_text_bytes_ = 0;
+    size_t released_text_bytes_ = 0;
+};
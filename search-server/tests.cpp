@@ -0,0 +1,325 @@
+#include "benchmarks/corpus_generator.h"
+#include "mutation_log.h"
+#include "search_server.h"
+#include "sharded_search_server.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <execution>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Сверка разных путей выполнения одного и того же запроса: все они обязаны давать
+// побитово одинаковые результаты. Код возврата ненулевой, если хотя бы одна проверка не прошла
+
+namespace {
+
+const string kSnapshotPath = "tests_snapshot.idx"s;
+const string kLogPath = "tests_mutation.log"s;
+const string kLogPrefixPath = "tests_mutation_prefix.log"s;
+
+void Check(bool condition, const string& what) {
+    if (!condition) {
+        throw logic_error(what);
+    }
+}
+
+bool AreEqual(const vector<Document>& lhs, const vector<Document>& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t index = 0; index < lhs.size(); ++index) {
+        if (lhs[index].id != rhs[index].id || lhs[index].relevance != rhs[index].relevance
+            || lhs[index].rating != rhs[index].rating) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Corpus {
+    vector<string> dictionary;
+    vector<string> texts;
+    vector<string> queries;
+};
+
+// Тексты с частотами слов по Ципфу, запросы - с минус-словами
+Corpus GenerateCorpus(unsigned seed, int document_count, int query_count) {
+    mt19937 generator(seed);
+    Corpus corpus;
+    corpus.dictionary = GenerateDictionary(generator, 2'000, 8);
+    const ZipfDistribution zipf(corpus.dictionary.size(), 1.0);
+    corpus.texts = GenerateZipfTexts(generator, corpus.dictionary, zipf, document_count, 3, 40);
+    corpus.queries = GenerateZipfTexts(generator, corpus.dictionary, zipf, query_count, 1, 5, 0.15);
+    return corpus;
+}
+
+DocumentStatus GetStatus(int document_id) {
+    return static_cast<DocumentStatus>(document_id % 7 == 0 ? document_id % 4 : 0);
+}
+
+vector<int> GetRatings(int document_id) {
+    return {document_id % 11 - 3, document_id % 5};
+}
+
+template <typename Server>
+void AddCorpus(Server& server, const Corpus& corpus) {
+    for (int document_id = 0; document_id < static_cast<int>(corpus.texts.size()); ++document_id) {
+        server.AddDocument(document_id, corpus.texts[document_id], GetStatus(document_id), GetRatings(document_id));
+    }
+}
+
+bool IsOddRated(int document_id, DocumentStatus status, int rating) {
+    return document_id % 3 != 0 && status != DocumentStatus::BANNED && rating % 2 != 0;
+}
+
+// Ответы всех серверов на запрос со статусом, с предикатом и с разными max_result_count
+template <typename LhsServer, typename RhsServer>
+void CheckSameResults(const LhsServer& lhs, const RhsServer& rhs, const vector<string>& queries, const string& what) {
+    for (const string& query : queries) {
+        for (const size_t max_result_count : {1, 5, 50}) {
+            for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED, DocumentStatus::REMOVED}) {
+                Check(AreEqual(lhs.FindTopDocuments(query, status, max_result_count),
+                               rhs.FindTopDocuments(query, status, max_result_count)),
+                      what + ": query \""s + query + "\" by status"s);
+            }
+            Check(AreEqual(lhs.FindTopDocuments(query, IsOddRated, max_result_count),
+                           rhs.FindTopDocuments(query, IsOddRated, max_result_count)),
+                  what + ": query \""s + query + "\" by predicate"s);
+        }
+    }
+}
+
+void TestWandMatchesTermAtATime() {
+    const Corpus corpus = GenerateCorpus(1, 8'000, 400);
+    SearchServer term_at_a_time(corpus.dictionary.front());
+    AddCorpus(term_at_a_time, corpus);
+    vector<int> removed_ids;
+    for (int document_id = 0; document_id < static_cast<int>(corpus.texts.size()); document_id += 5) {
+        removed_ids.push_back(document_id);
+    }
+    term_at_a_time.RemoveDocuments(removed_ids);
+    SearchServer wand = term_at_a_time;
+    term_at_a_time.SetQueryEngine(QueryEngine::TERM_AT_A_TIME);
+    wand.SetQueryEngine(QueryEngine::WAND);
+    CheckSameResults(term_at_a_time, wand, corpus.queries, "WAND"s);
+    for (const string& query : corpus.queries) {
+        Check(AreEqual(term_at_a_time.FindTopDocuments(query), wand.FindTopDocuments(wand.PrepareQuery(query))),
+              "prepared WAND: query \""s + query + "\""s);
+    }
+}
+
+// Параллельные перегрузки против последовательных, для обоих способов обхода
+template <typename Server>
+void CheckParallelMatchesSequential(const Server& server, const vector<string>& queries, const string& what) {
+    for (const string& query : queries) {
+        Check(AreEqual(server.FindTopDocuments(execution::seq, query), server.FindTopDocuments(execution::par, query)),
+              what + ": query \""s + query + "\""s);
+        Check(AreEqual(server.FindTopDocuments(execution::seq, query, DocumentStatus::BANNED),
+                       server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED)),
+              what + ": query \""s + query + "\" by status"s);
+        Check(AreEqual(server.FindTopDocuments(execution::seq, query, IsOddRated, 50),
+                       server.FindTopDocuments(execution::par, query, IsOddRated, 50)),
+              what + ": query \""s + query + "\" by predicate"s);
+    }
+}
+
+void TestParallelMatchesSequential() {
+    const Corpus corpus = GenerateCorpus(2, 8'000, 300);
+    SearchServer search_server(corpus.dictionary.front());
+    AddCorpus(search_server, corpus);
+    for (const QueryEngine query_engine : {QueryEngine::TERM_AT_A_TIME, QueryEngine::WAND}) {
+        search_server.SetQueryEngine(query_engine);
+        CheckParallelMatchesSequential(search_server, corpus.queries, "parallel search"s);
+    }
+    for (const string& query : corpus.queries) {
+        for (int document_id = 1; document_id < 200; document_id += 37) {
+            try {
+                Check(search_server.MatchDocument(execution::seq, query, document_id)
+                          == search_server.MatchDocument(execution::par, query, document_id),
+                      "parallel match: query \""s + query + "\""s);
+            } catch (const invalid_argument&) {
+            }
+        }
+    }
+}
+
+void TestShardedMatchesSingle() {
+    const Corpus corpus = GenerateCorpus(3, 8'000, 300);
+    SearchServer single(corpus.dictionary.front());
+    ShardedSearchServer sharded(corpus.dictionary.front(), 5);
+    AddCorpus(single, corpus);
+    AddCorpus(sharded, corpus);
+    vector<int> removed_ids;
+    for (int document_id = 0; document_id < static_cast<int>(corpus.texts.size()); document_id += 7) {
+        removed_ids.push_back(document_id);
+    }
+    single.RemoveDocuments(removed_ids);
+    sharded.RemoveDocuments(removed_ids);
+    Check(single.GetDocumentCount() == sharded.GetDocumentCount(), "sharded document count"s);
+    for (const QueryEngine query_engine : {QueryEngine::TERM_AT_A_TIME, QueryEngine::WAND}) {
+        single.SetQueryEngine(query_engine);
+        sharded.SetQueryEngine(query_engine);
+        CheckSameResults(single, sharded, corpus.queries, "sharded"s);
+        CheckParallelMatchesSequential(sharded, corpus.queries, "parallel sharded"s);
+    }
+}
+
+void TestSnapshotMatchesMemoryAfterRemoves() {
+    const Corpus corpus = GenerateCorpus(4, 6'000, 300);
+    const int document_count = static_cast<int>(corpus.texts.size());
+    SearchServer in_memory(corpus.dictionary.front());
+    AddCorpus(in_memory, corpus);
+    mt19937 generator(4);
+    uniform_int_distribution<int> document_id(0, document_count - 1);
+    for (int index = 0; index < document_count / 10; ++index) {
+        in_memory.RemoveDocument(document_id(generator));
+    }
+    in_memory.SaveSnapshot(kSnapshotPath);
+    SearchServer from_snapshot = SearchServer::OpenSnapshot(kSnapshotPath, true, true);
+    CheckSameResults(in_memory, from_snapshot, corpus.queries, "snapshot"s);
+
+    // Удаления из открытого снимка и из индекса в памяти должны давать одно и то же
+    vector<int> removed_ids;
+    for (int index = 0; index < document_count / 10; ++index) {
+        removed_ids.push_back(document_id(generator));
+    }
+    in_memory.RemoveDocuments(execution::par, removed_ids);
+    from_snapshot.RemoveDocuments(removed_ids);
+    Check(in_memory.GetDocumentCount() == from_snapshot.GetDocumentCount(), "snapshot document count after removes"s);
+    CheckSameResults(in_memory, from_snapshot, corpus.queries, "snapshot after removes"s);
+    for (int id = 0; id < document_count; id += 13) {
+        Check(in_memory.GetWordFrequencies(id) == from_snapshot.GetWordFrequencies(id), "snapshot word frequencies"s);
+    }
+    remove(kSnapshotPath.c_str());
+}
+
+size_t GetFileSize(const string& path) {
+    ifstream in(path, ios::binary | ios::ate);
+    return in ? static_cast<size_t>(in.tellg()) : 0;
+}
+
+string ReadFile(const string& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void WriteFile(const string& path, const string& content) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(content.data(), content.size());
+}
+
+void CheckSameIndex(SearchServer& lhs, SearchServer& rhs, const vector<string>& queries, const string& what) {
+    Check(vector<int>(lhs.begin(), lhs.end()) == vector<int>(rhs.begin(), rhs.end()), what + ": document ids"s);
+    for (const int document_id : lhs) {
+        Check(lhs.GetWordFrequencies(document_id) == rhs.GetWordFrequencies(document_id), what + ": word frequencies"s);
+    }
+    CheckSameResults(lhs, rhs, queries, what);
+}
+
+// Журнал, оборванный на любом байте, применяется как его целые записи:
+// и Replay, и открытие журнала для дозаписи отбрасывают оборванный хвост
+void TestMutationLogReplayAtEveryOffset() {
+    const Corpus corpus = GenerateCorpus(5, 40, 20);
+    const string stop_words = corpus.dictionary.front();
+
+    // Каждое изменение записано в журнал; expected[k] - индекс после первых k изменений
+    vector<function<void(SearchServer&)>> mutations;
+    for (int document_id = 0; document_id < 30; ++document_id) {
+        mutations.push_back([&corpus, document_id](SearchServer& server) {
+            server.AddDocument(document_id, corpus.texts[document_id], GetStatus(document_id), GetRatings(document_id));
+        });
+        if (document_id % 6 == 5) {
+            mutations.push_back([document_id](SearchServer& server) {
+                server.RemoveDocuments({document_id - 5, document_id - 2});
+            });
+            mutations.push_back([&corpus, document_id](SearchServer& server) {
+                // Тот же id с другим текстом: при применении побеждает последняя запись
+                server.AddDocument(document_id - 5, corpus.texts[document_id + 5], DocumentStatus::BANNED, {7});
+            });
+        }
+    }
+
+    remove(kLogPath.c_str());
+    vector<size_t> record_ends;
+    {
+        MutationLogOptions options;
+        options.fsync = false;
+        auto mutation_log = make_shared<MutationLog>(kLogPath, options);
+        SearchServer logged(stop_words);
+        logged.SetMutationLog(mutation_log);
+        record_ends.push_back(GetFileSize(kLogPath));
+        for (const auto& mutation : mutations) {
+            mutation(logged);
+            mutation_log->Sync();
+            record_ends.push_back(GetFileSize(kLogPath));
+        }
+    }
+    vector<SearchServer> expected;
+    expected.emplace_back(stop_words);
+    for (const auto& mutation : mutations) {
+        expected.push_back(expected.back());
+        mutation(expected.back());
+    }
+
+    const string content = ReadFile(kLogPath);
+    Check(content.size() == record_ends.back(), "mutation log size"s);
+    for (size_t size = 0; size <= content.size(); ++size) {
+        const string what = "mutation log cut at "s + to_string(size);
+        WriteFile(kLogPrefixPath, content.substr(0, size));
+        SearchServer replayed(stop_words);
+        if (size > 0 && size < record_ends.front()) {
+            // Оборванный заголовок - не журнал
+            try {
+                MutationLog::Replay(kLogPrefixPath, replayed);
+                Check(false, what + ": truncated header accepted"s);
+            } catch (const invalid_argument&) {
+            }
+            continue;
+        }
+        const size_t record_count =
+            size == 0 ? 0 : upper_bound(record_ends.begin(), record_ends.end(), size) - record_ends.begin() - 1;
+        Check(MutationLog::Replay(kLogPrefixPath, replayed) == record_count, what + ": record count"s);
+        CheckSameIndex(expected[record_count], replayed, corpus.queries, what);
+
+        {
+            MutationLogOptions options;
+            options.fsync = false;
+            const MutationLog repaired(kLogPrefixPath, options);
+        }
+        Check(GetFileSize(kLogPrefixPath) == record_ends[record_count], what + ": tail not repaired"s);
+    }
+    remove(kLogPath.c_str());
+    remove(kLogPrefixPath.c_str());
+}
+
+}  // namespace
+
+int main() {
+    const vector<pair<string, void (*)()>> tests = {
+        {"TestWandMatchesTermAtATime"s, TestWandMatchesTermAtATime},
+        {"TestParallelMatchesSequential"s, TestParallelMatchesSequential},
+        {"TestShardedMatchesSingle"s, TestShardedMatchesSingle},
+        {"TestSnapshotMatchesMemoryAfterRemoves"s, TestSnapshotMatchesMemoryAfterRemoves},
+        {"TestMutationLogReplayAtEveryOffset"s, TestMutationLogReplayAtEveryOffset},
+    };
+    int failed = 0;
+    for (const auto& [name, test] : tests) {
+        try {
+            test();
+            cerr << name << " OK"s << endl;
+        } catch (const exception& e) {
+            cerr << name << " failed: "s << e.what() << endl;
+            ++failed;
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#include "text_arena.h"
+
+#include <cstring>
+
+using namespace std;
+
+string_view TextArena::Store(string_view text) {
+    char* data = nullptr;
+    if (text.size() > kChunkSize / 4) {
+        // Длинные строки получают отдельный блок, чтобы не бросать остаток текущего
+        data = Allocate(text.size());
+    } else {
+        if (text.size() > current_left_) {
+            current_ = Allocate(kChunkSize);
+            current_left_ = kChunkSize;
+        }
+        data = current_;
+        current_ += text.size();
+        current_left_ -= text.size();
+    }
+    memcpy(data, text.data(), text.size());
+    return {data, text.size()};
+}
+
+size_t TextArena::GetMemoryUsage() const {
+    return allocated_ + chunks_.capacity() * sizeof(chunks_[0]);
+}
+
+char* TextArena::Allocate(size_t size) {
+    chunks_.push_back(make_unique<char[]>(size));
+    allocated_ += size;
+    return chunks_.back().get();
+}
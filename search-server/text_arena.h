@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Хранилище строк, выделяемое крупными блоками. Сохранённые строки не
+// перемещаются и живут до уничтожения арены, поэтому string_view на них стабильны.
+class TextArena {
+public:
+    std::string_view Store(std::string_view text);
+
+    size_t GetMemoryUsage() const;
+
+private:
+    static const size_t kChunkSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char* current_ = nullptr;
+    size_t current_left_ = 0;
+    size_t allocated_ = 0;
+
+    char* Allocate(size_t size);
+};
@@ -0,0 +1,77 @@
+#include "top_documents.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "query_executor.h"
+#include "query_trace.h"
+
+using namespace std;
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (abs(lhs.relevance - rhs.relevance) >= kEpsilon) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
+
+namespace {
+
+void SelectTopDocumentsImpl(vector<Document>& documents, size_t count) {
+    if (documents.size() > count) {
+        nth_element(documents.begin(), documents.begin() + count, documents.end(), IsMoreRelevant);
+        documents.resize(count);
+    }
+    sort(documents.begin(), documents.end(), IsMoreRelevant);
+}
+
+}  // namespace
+
+void SelectTopDocuments(vector<Document>& documents, size_t count) {
+    SelectTopDocuments(execution::seq, documents, count);
+}
+
+void SelectTopDocuments(const execution::sequenced_policy&, vector<Document>& documents, size_t count) {
+    QueryStageTimer timer(QueryStage::TOP_K);
+    SelectTopDocumentsImpl(documents, count);
+}
+
+void SelectTopDocuments(const execution::parallel_policy&, vector<Document>& documents, size_t count) {
+    QueryStageTimer timer(QueryStage::TOP_K);
+    QueryExecutor& executor = QueryExecutor::GetCurrent();
+    const size_t chunk_count = executor.GetThreadCount();
+    const size_t chunk_size = (documents.size() + chunk_count - 1) / chunk_count;
+    if (chunk_count == 1 || chunk_size <= count) {
+        SelectTopDocumentsImpl(documents, count);
+        return;
+    }
+
+    // Каждый поток отбирает локальный top-K своей части, затем кандидаты сливаются
+    vector<size_t> chunk_begins;
+    for (size_t begin = 0; begin < documents.size(); begin += chunk_size) {
+        chunk_begins.push_back(begin);
+    }
+    executor.ParallelFor(chunk_begins.size(), 1,
+             [&documents, &chunk_begins, chunk_size, count](size_t chunk) {
+                 const size_t begin = chunk_begins[chunk];
+                 const auto first = documents.begin() + begin;
+                 const auto last = documents.begin() + min(begin + chunk_size, documents.size());
+                 if (static_cast<size_t>(distance(first, last)) > count) {
+                     nth_element(first, first + count, last, IsMoreRelevant);
+                 }
+             });
+
+    vector<Document> candidates;
+    candidates.reserve(chunk_begins.size() * count);
+    for (const size_t begin : chunk_begins) {
+        const auto first = documents.begin() + begin;
+        const auto last = first + min(count, min(chunk_size, documents.size() - begin));
+        candidates.insert(candidates.end(), first, last);
+    }
+    SelectTopDocumentsImpl(candidates, count);
+    documents = move(candidates);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <execution>
+#include <vector>
+
+#include "document.h"
+
+const double kEpsilon = 1e-6;
+
+// Порядок выдачи: релевантность (с точностью kEpsilon), затем рейтинг, затем id
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+// Оставляет в documents не более count лучших документов, упорядоченных по IsMoreRelevant.
+// Полная сортировка не выполняется: отбор через nth_element, сортируется только результат.
+void SelectTopDocuments(std::vector<Document>& documents, size_t count);
+void SelectTopDocuments(const std::execution::sequenced_policy&, std::vector<Document>& documents, size_t count);
+void SelectTopDocuments(const std::execution::parallel_policy&, std::vector<Document>& documents, size_t count);